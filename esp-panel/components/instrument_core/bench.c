@@ -0,0 +1,162 @@
+/* Benchmark mode: on-target latency and jitter measurement.
+ *
+ * Only compiled when CONFIG_PANEL_BENCHMARK is set; production builds pay
+ * nothing. A replay task feeds a canned command script through the real
+ * receive path (loopback UDP to the command port), the hooks in net.c and
+ * motor.c timestamp each stage with esp_timer_get_time, and a text report
+ * with the latency histogram and worst-case ISR jitter goes out on the
+ * stats port after every pass.
+ */
+#include "sdkconfig.h"
+
+#if CONFIG_PANEL_BENCHMARK
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "panel_proto.h"
+#include "instrument_internal.h"
+
+static const char *TAG = "bench";
+
+#define BENCH_RPI_IP        CONFIG_RPI_IP_ADDRESS
+#define BENCH_COMMAND_PORT  49003
+#define BENCH_SCRIPT_GAP_MS 500
+#define BENCH_PASS_GAP_MS   10000
+
+// Dispatch latency histogram: datagram arrival to handler done
+static const uint32_t bucket_limit_us[] = {50, 100, 200, 500, 1000, 2000, 5000};
+#define BENCH_BUCKETS (sizeof(bucket_limit_us) / sizeof(bucket_limit_us[0]) + 1)
+
+static uint32_t dispatch_hist[BENCH_BUCKETS];
+static uint32_t dispatch_max_us;
+
+// Command-to-first-step: set when motor_move_to arms the timer from
+// standstill, resolved by the first ISR tick that follows
+static volatile int64_t first_step_cmd_us;
+static volatile bool await_first_step;
+static volatile uint32_t first_step_latency_us;
+
+// ISR jitter: deviation of each step interval from the period armed for it
+static int64_t isr_last_tick_us;
+static uint32_t isr_expected_us;
+static volatile uint32_t isr_jitter_max_us;
+
+void bench_record_dispatch(uint32_t dispatch_us)
+{
+    int b = 0;
+    while (b < (int)BENCH_BUCKETS - 1 && dispatch_us >= bucket_limit_us[b]) {
+        b++;
+    }
+    dispatch_hist[b]++;
+    if (dispatch_us > dispatch_max_us) {
+        dispatch_max_us = dispatch_us;
+    }
+}
+
+void bench_command_armed(void)
+{
+    first_step_cmd_us = esp_timer_get_time();
+    await_first_step = true;
+}
+
+// Called from the step ISR on every tick. next_period_us is the alarm
+// period just armed for the following step, 0 when the move completed
+// (no further tick is expected, so the interval chain restarts).
+void bench_step_isr(uint32_t next_period_us)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (await_first_step) {
+        first_step_latency_us = (uint32_t)(now - first_step_cmd_us);
+        await_first_step = false;
+    }
+
+    if (isr_expected_us != 0 && isr_last_tick_us != 0) {
+        int32_t dev = (int32_t)(now - isr_last_tick_us) - (int32_t)isr_expected_us;
+        if (dev < 0) dev = -dev;
+        if ((uint32_t)dev > isr_jitter_max_us) {
+            isr_jitter_max_us = (uint32_t)dev;
+        }
+    }
+    isr_last_tick_us = (next_period_us != 0) ? now : 0;
+    isr_expected_us = next_period_us;
+}
+
+// Canned script: a slew across the dial, small corrections, a reversal.
+// Replayed through loopback UDP so the datagrams take the same socket,
+// decode and dispatch path as real hub traffic.
+static const int bench_script[] = {270, 90, 100, 110, 105, 180, 0, 315, 45};
+#define BENCH_SCRIPT_LEN (sizeof(bench_script) / sizeof(bench_script[0]))
+
+static void bench_report(int sock, struct sockaddr_in *dest, int pass)
+{
+    char report[320];
+    int n = snprintf(report, sizeof(report),
+        "BENCH:%s:pass=%d disp_us[<50:%lu <100:%lu <200:%lu <500:%lu "
+        "<1000:%lu <2000:%lu <5000:%lu >=5000:%lu] disp_max=%lu "
+        "first_step=%lu jitter_max=%lu",
+        CONFIG_ESP_DEVICE_ID, pass,
+        (unsigned long)dispatch_hist[0], (unsigned long)dispatch_hist[1],
+        (unsigned long)dispatch_hist[2], (unsigned long)dispatch_hist[3],
+        (unsigned long)dispatch_hist[4], (unsigned long)dispatch_hist[5],
+        (unsigned long)dispatch_hist[6], (unsigned long)dispatch_hist[7],
+        (unsigned long)dispatch_max_us, (unsigned long)first_step_latency_us,
+        (unsigned long)isr_jitter_max_us);
+
+    sendto(sock, report, n, 0, (struct sockaddr *)dest, sizeof(*dest));
+    ESP_LOGI(TAG, "%s", report);
+}
+
+static void bench_task(void *pvParameters)
+{
+    // Let the receiver, motors and WiFi settle before measuring
+    vTaskDelay(pdMS_TO_TICKS(3000));
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Benchmark socket failed");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    struct sockaddr_in self_addr = {0};
+    self_addr.sin_family = AF_INET;
+    self_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    self_addr.sin_port = htons(BENCH_COMMAND_PORT);
+
+    struct sockaddr_in report_addr = {0};
+    report_addr.sin_family = AF_INET;
+    report_addr.sin_addr.s_addr = inet_addr(BENCH_RPI_IP);
+    report_addr.sin_port = htons(PANEL_STATS_PORT);
+
+    ESP_LOGI(TAG, "Benchmark mode: replaying %d-command script", (int)BENCH_SCRIPT_LEN);
+
+    int pass = 0;
+    while (1) {
+        for (int i = 0; i < (int)BENCH_SCRIPT_LEN; i++) {
+            char msg[32];
+            int n = snprintf(msg, sizeof(msg), "MOVE:0:%d:0:360", bench_script[i]);
+            sendto(sock, msg, n, 0, (struct sockaddr *)&self_addr, sizeof(self_addr));
+            vTaskDelay(pdMS_TO_TICKS(BENCH_SCRIPT_GAP_MS));
+        }
+        pass++;
+        bench_report(sock, &report_addr, pass);
+        vTaskDelay(pdMS_TO_TICKS(BENCH_PASS_GAP_MS));
+    }
+}
+
+void bench_start(void)
+{
+    if (instrument_desc->motor_count == 0) {
+        ESP_LOGW(TAG, "Benchmark mode needs a motor, not starting");
+        return;
+    }
+    xTaskCreate(bench_task, "bench", 4096, NULL, 2, NULL);
+}
+
+#endif // CONFIG_PANEL_BENCHMARK
@@ -0,0 +1,108 @@
+/* Shared instrument engine for the panel firmwares.
+ *
+ * The networking, logging, OLED and stepper code used to be copy-pasted
+ * across all seven instrument firmwares. Each instrument now provides an
+ * instrument_desc_t (its calibration tables, pins and dispatch hooks) and
+ * calls instrument_core_start() from app_main; every performance fix in
+ * the core lands in all binaries at once.
+ */
+#ifndef INSTRUMENT_CORE_H
+#define INSTRUMENT_CORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+// Hot-path logging: the per-packet and per-command logs (including those
+// in instrument on_value hooks) are useful when bringing up an instrument
+// but dominate the receive path at stream rates, and runtime filtering
+// still evaluates the arguments. Production builds (PANEL_PRODUCTION in
+// menuconfig) compile them out entirely; the panel counters keep the
+// stats surface showing activity. Cold-path logs (init, WiFi, parse
+// failures of malformed packets) stay in all builds.
+// The if (0) keeps the arguments (and each file's TAG) referenced and
+// type-checked while the compiler discards the call entirely.
+#if CONFIG_PANEL_PRODUCTION
+#define PANEL_HOT_LOGI(tag, fmt, ...) do { if (0) ESP_LOGI(tag, fmt, ##__VA_ARGS__); } while (0)
+#define PANEL_HOT_LOGW(tag, fmt, ...) do { if (0) ESP_LOGW(tag, fmt, ##__VA_ARGS__); } while (0)
+#else
+#define PANEL_HOT_LOGI(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define PANEL_HOT_LOGW(tag, fmt, ...) ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#endif
+
+// Calibration points: instrument value -> angle (degrees on gauge)
+typedef struct {
+    int value;
+    int angle;
+} cal_point_t;
+
+// How a motor travels to a new target angle
+typedef enum {
+    MOTOR_PATH_CLAMP = 0,      // Clamp to bounds and move directly
+    MOTOR_PATH_WRAP_SHORTEST,  // 0-360 dial, take the shortest way around
+    MOTOR_PATH_WRAP_AVOID,     // 0-360 dial, never cross avoid_angle
+} motor_path_mode_t;
+
+typedef struct {
+    int pin_in1;
+    int pin_in2;
+    int pin_in3;
+    int pin_in4;
+    bool reverse_pins;          // Coil order reversed to fix direction
+    const cal_point_t *calibration;
+    int calibration_count;
+    int min_angle;              // Default command bounds (BOUNDS: overrides)
+    int max_angle;
+    int zero_angle;             // Position assumed at boot and after ZERO
+    bool reject_out_of_bounds;  // Reject out-of-range targets instead of clamping
+    motor_path_mode_t path_mode;
+    int avoid_angle;            // MOTOR_PATH_WRAP_AVOID: angle never crossed
+    // Step ramp: accelerate from the standstill-safe period to the cruise
+    // period, MOTOR_RAMP_STEP_US of period change per step
+    uint32_t ramp_start_period_us;
+    uint32_t ramp_min_period_us;
+    uint32_t ramp_step_us;
+} motor_config_t;
+
+#define INSTRUMENT_MAX_MOTORS     2
+#define INSTRUMENT_MAX_CAL_POINTS 16
+
+typedef struct {
+    const char *name;          // Shown on the OLED and in boot logs
+    bool has_oled;
+    int motor_count;           // 0 for input-only devices
+    motor_config_t motors[INSTRUMENT_MAX_MOTORS];
+    // Optional VALUE hook: return true if the command was fully handled,
+    // false to fall back to calibration lookup on the addressed motor.
+    bool (*on_value)(int motor_id, int value);
+    // Optional ZERO hook; the default resets the motor to its zero_angle.
+    void (*on_zero)(int motor_id);
+} instrument_desc_t;
+
+// Brings up the watchdog, motors, OLED, WiFi, logging, heartbeat and UDP
+// receiver, then returns; app_main keeps its idle loop.
+void instrument_core_start(const instrument_desc_t *desc);
+
+// Calibration lookup and motor control, for instrument dispatch hooks
+int  instrument_value_to_angle(int motor_id, int value);
+// Replace the motor's calibration table at runtime (CAL: text command).
+// Validates the points, persists them to NVS and recomputes the
+// interpolation slopes; returns false and keeps the old table on bad input.
+bool instrument_motor_set_calibration(int motor_id, const cal_point_t *points, int count);
+void instrument_motor_command(int motor_id, int target_angle, int min_angle, int max_angle);
+void instrument_motor_zero(int motor_id, int zero_angle);
+// Current dial angle in degrees
+int  instrument_motor_angle(int motor_id);
+
+// Queue a status update for the OLED (no-op on boards without one). Never
+// blocks: the lines go through a single-slot mailbox to a low-priority
+// render task, so this is safe to call from the receive path.
+void instrument_oled_status(const char *l1, const char *l2, const char *l3);
+
+// Runtime command bounds, initialized from the motor config; the BOUNDS:
+// text command updates them
+extern int instrument_motor_min[INSTRUMENT_MAX_MOTORS];
+extern int instrument_motor_max[INSTRUMENT_MAX_MOTORS];
+
+#endif // INSTRUMENT_CORE_H
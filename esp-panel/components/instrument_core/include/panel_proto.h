@@ -0,0 +1,106 @@
+/* Binary UDP command protocol shared by the hub and all instrument firmwares.
+ *
+ * The text protocol ("VALUE:", "ANGLE:", "MOVE:", "ZERO:") is kept as a
+ * fallback for the web server calibration tools, but the hub streams
+ * X-Plane data as fixed-layout binary frames so the per-packet cost on the
+ * ESP is one memcpy and one switch instead of strncmp plus repeated sscanf.
+ */
+#ifndef PANEL_PROTO_H
+#define PANEL_PROTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// First byte of every binary frame. No text command starts with 0xA5, so a
+// failed decode falls through to the text parser untouched.
+#define PANEL_MAGIC     0xA5
+
+#define PANEL_OP_VALUE  0x01  // instrument value, converted via calibration
+#define PANEL_OP_ANGLE  0x02  // raw gauge angle in degrees
+#define PANEL_OP_MOVE   0x03  // angle with explicit min/max bounds
+#define PANEL_OP_ZERO   0x04  // reset position tracking
+#define PANEL_OP_VALUE2 0x05  // both motors' values in one frame (see below)
+
+// All multi-byte fields are little-endian, which matches both the ESP32-C3
+// and the hub, so decoding is a straight struct copy with no byte swapping.
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;      // PANEL_MAGIC
+    uint8_t  opcode;     // PANEL_OP_*
+    uint8_t  motor_id;   // 0 or 1
+    uint8_t  flags;      // reserved, must be 0
+    int32_t  value;      // VALUE/ANGLE/MOVE target; VALUE2: motor 0 value
+    int32_t  min_angle;  // MOVE only; VALUE2: motor 1 value; 0 otherwise
+    int32_t  max_angle;  // MOVE only, 0 otherwise
+    uint16_t seq;        // wrapping sequence number, for diagnostics
+    uint16_t reserved;
+} panel_frame_t;
+
+// Multicast bundle: one datagram per sim frame carrying values for every
+// instrument, sent to PANEL_MCAST_GROUP on the command port. Each device
+// filters entries against its own ESP_ID, so all needles receive their
+// data in the same airtime slot instead of seven serialized unicasts.
+#define PANEL_BUNDLE_MAGIC 0xA7
+#define PANEL_MCAST_GROUP  "239.255.49.3"
+
+// Sized for the longest configured device id (ESP_AttitudeIndicator, 21
+// chars) plus NUL padding; the hub warns if an id ever outgrows it
+typedef struct __attribute__((packed)) {
+    char     esp_id[24];  // NUL-padded target device id
+    uint8_t  motor_id;
+    uint8_t  reserved;
+    uint16_t reserved2;
+    int32_t  value;       // instrument value, as in PANEL_OP_VALUE
+} panel_bundle_entry_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;       // PANEL_BUNDLE_MAGIC
+    uint8_t  count;       // number of entries that follow
+    uint16_t seq;         // wrapping sequence number, for diagnostics
+    panel_bundle_entry_t entries[];
+} panel_bundle_t;
+
+// Periodic performance stats, sent by each firmware to the hub on
+// PANEL_STATS_PORT every few seconds. Counters are cumulative since boot
+// except max_dispatch_us, which is the worst receive-to-command latency
+// observed since the previous stats frame.
+#define PANEL_STATS_MAGIC   0xA6
+#define PANEL_STATS_VERSION 2
+#define PANEL_STATS_PORT    49005
+
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;            // PANEL_STATS_MAGIC
+    uint8_t  version;          // PANEL_STATS_VERSION
+    uint16_t reserved;
+    char     esp_id[24];       // NUL-padded device id
+    uint32_t uptime_s;
+    uint32_t rx_packets;       // datagrams received
+    uint32_t rx_binary;        // decoded as binary frames
+    uint32_t rx_text;          // handled by the text parser
+    uint32_t rx_errors;        // neither binary nor a known text command
+    uint32_t motor_steps;      // steps executed across all motors
+    uint32_t isr_overruns;     // step deadlines already past when re-arming
+    uint32_t log_dropped;      // log lines dropped by the ring buffer
+    uint32_t free_heap;        // bytes
+    uint32_t max_dispatch_us;  // worst receive-to-dispatch latency in window
+                               // (to command dispatch, not to first step;
+                               // benchmark mode measures the full path)
+} panel_stats_frame_t;
+
+// Returns true if buf holds a well-formed binary frame and copies it to out.
+static inline bool panel_frame_decode(const void *buf, int len, panel_frame_t *out)
+{
+    if (len != (int)sizeof(panel_frame_t)) {
+        return false;
+    }
+    memcpy(out, buf, sizeof(panel_frame_t));
+    if (out->magic != PANEL_MAGIC) {
+        return false;
+    }
+    if (out->opcode < PANEL_OP_VALUE || out->opcode > PANEL_OP_VALUE2) {
+        return false;
+    }
+    return true;
+}
+
+#endif // PANEL_PROTO_H
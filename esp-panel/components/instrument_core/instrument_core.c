@@ -0,0 +1,47 @@
+/* Startup orchestration: same bring-up order the standalone firmwares used. */
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_task_wdt.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "instrument_internal.h"
+
+static const char *TAG = "instrument_core";
+
+const instrument_desc_t *instrument_desc = NULL;
+
+void instrument_core_start(const instrument_desc_t *desc)
+{
+    instrument_desc = desc;
+    ESP_LOGI(TAG, "Starting %s", desc->name);
+
+    esp_task_wdt_config_t wdt_config = {
+        .timeout_ms = 60000,
+        .idle_core_mask = (1 << portNUM_PROCESSORS) - 1,
+        .trigger_panic = true,
+    };
+    esp_task_wdt_init(&wdt_config);
+
+    // NVS before the motor engine: stored calibration tables load at init
+    ESP_ERROR_CHECK(nvs_flash_init());
+    motor_engine_init();
+    init_oled();
+    oled_display(desc->name, "CONNECTING", NULL);
+    wifi_init();
+    // Event-driven start: tasks launch the moment the interface has an
+    // address instead of after a fixed 5-second sleep; the timeout keeps
+    // the firmware serviceable when the AP is down
+    if (!net_wait_for_ip(10000)) {
+        ESP_LOGW(TAG, "No IP after 10 s, starting tasks anyway");
+    }
+
+    net_logging_start();
+    motor_engine_start_tasks();
+    net_start_tasks();
+
+#if CONFIG_PANEL_BENCHMARK
+    bench_start();
+#endif
+
+    ESP_LOGI(TAG, "Initialization complete. Ready for commands.");
+}
@@ -0,0 +1,53 @@
+/* Internals shared between the instrument_core translation units. */
+#ifndef INSTRUMENT_INTERNAL_H
+#define INSTRUMENT_INTERNAL_H
+
+#include "instrument_core.h"
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+// Descriptor of the instrument this firmware was built for
+extern const instrument_desc_t *instrument_desc;
+
+// Hot-path performance counters, plain volatile increments (a handful of
+// cycles each) so they stay on in production. Shipped to the hub by the
+// stats task in net.c as a panel_stats_frame_t.
+typedef struct {
+    volatile uint32_t rx_packets;
+    volatile uint32_t rx_binary;
+    volatile uint32_t rx_text;
+    volatile uint32_t rx_errors;
+    volatile uint32_t motor_steps;
+    volatile uint32_t isr_overruns;  // step deadlines already past when re-arming
+    volatile uint32_t log_dropped;
+    volatile uint32_t max_dispatch_us;  // reset after every stats frame
+} panel_counters_t;
+
+extern panel_counters_t panel_counters;
+
+// motor.c
+void motor_engine_init(void);
+void motor_engine_start_tasks(void);
+
+// net.c
+void wifi_init(void);
+bool net_wait_for_ip(int timeout_ms);
+void net_logging_start(void);
+void net_start_tasks(void);
+
+// oled.c
+void init_oled(void);
+void oled_display(const char *l1, const char *l2, const char *l3);
+void oled_show_ip(const char *ip);
+
+#if CONFIG_PANEL_BENCHMARK
+// bench.c -- latency/jitter instrumentation, compiled out of normal builds.
+// The hooks are called from the receive path and the step ISR.
+void bench_record_dispatch(uint32_t dispatch_us);
+void bench_command_armed(void);
+void bench_step_isr(uint32_t next_period_us);
+void bench_start(void);
+#endif
+
+#endif // INSTRUMENT_INTERNAL_H
@@ -0,0 +1,751 @@
+/* Stepper engine shared by all instruments.
+ *
+ * One 28BYJ-48 per motor slot, driven from a gptimer ISR. Commands are
+ * coalesced through a single-slot mailbox per motor, targets are absolute
+ * step counts that can be rewritten while the timer keeps running, and the
+ * step period follows a trapezoidal accelerate/cruise/decelerate ramp.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_timer.h"
+#include "soc/gpio_struct.h"
+#include "nvs_flash.h"
+#include "sdkconfig.h"
+#include "instrument_internal.h"
+
+static const char *TAG = "motor";
+
+// Older Kconfig.projbuild copies may predate the filtering options
+#ifndef CONFIG_MOTOR_DEADBAND_DEG
+#define CONFIG_MOTOR_DEADBAND_DEG 1
+#endif
+#ifndef CONFIG_MOTOR_RETARGET_MIN_MS
+#define CONFIG_MOTOR_RETARGET_MIN_MS 50
+#endif
+#ifndef CONFIG_MOTOR_CRUISE_PERIOD_US
+#define CONFIG_MOTOR_CRUISE_PERIOD_US 0
+#endif
+#ifndef CONFIG_MOTOR_HOLD_TIMEOUT_MS
+#define CONFIG_MOTOR_HOLD_TIMEOUT_MS 1000
+#endif
+#ifndef CONFIG_MOTOR_INTERPOLATE
+#define CONFIG_MOTOR_INTERPOLATE 1
+#endif
+
+// Slowest paced step rate: below 20 steps/s the needle reads as stopped
+// anyway, and pathological pacing must not stall a move
+#define MOTOR_PACE_MAX_PERIOD_US 50000
+
+// Drive mode is a compile-time choice (CONFIG_MOTOR_DRIVE_* in menuconfig).
+// Full step: two coils on, 2048 steps/rev. Half step: 8-entry sequence,
+// 4096 steps/rev, halves the ~0.18° needle quantization. Wave drive: one
+// coil on, 2048 steps/rev at lower torque and holding current. The step
+// math is parameterized on MOTOR_STEPS_PER_REV, so finer resolution costs
+// no extra runtime arithmetic.
+#if CONFIG_MOTOR_DRIVE_HALF_STEP
+#define SEQUENCE            SEQUENCE_HALF
+#define SEQUENCE_LEN        8
+#define MOTOR_STEPS_PER_REV 4096
+#elif CONFIG_MOTOR_DRIVE_WAVE
+#define SEQUENCE            SEQUENCE_WAVE
+#define SEQUENCE_LEN        4
+#define MOTOR_STEPS_PER_REV 2048
+#else
+#define SEQUENCE            SEQUENCE_FULL
+#define SEQUENCE_LEN        4
+#define MOTOR_STEPS_PER_REV 2048
+#endif
+
+// Full-step sequence: two coils energized per step
+static const uint8_t SEQUENCE_FULL[4][4] = {
+    {1, 1, 0, 0},
+    {0, 1, 1, 0},
+    {0, 0, 1, 1},
+    {1, 0, 0, 1},
+};
+
+#if CONFIG_MOTOR_DRIVE_HALF_STEP
+// Half-step sequence: alternates one and two coils for 4096 steps/rev
+static const uint8_t SEQUENCE_HALF[8][4] = {
+    {1, 0, 0, 0},
+    {1, 1, 0, 0},
+    {0, 1, 0, 0},
+    {0, 1, 1, 0},
+    {0, 0, 1, 0},
+    {0, 0, 1, 1},
+    {0, 0, 0, 1},
+    {1, 0, 0, 1},
+};
+#elif CONFIG_MOTOR_DRIVE_WAVE
+// Wave-drive sequence: one coil energized per step
+static const uint8_t SEQUENCE_WAVE[4][4] = {
+    {1, 0, 0, 0},
+    {0, 1, 0, 0},
+    {0, 0, 1, 0},
+    {0, 0, 0, 1},
+};
+#endif
+
+typedef struct {
+    int motor_id;
+    int target_angle;
+    int min_angle;
+    int max_angle;
+} motor_cmd_t;
+
+// Stall-safe floor for the cruise period: a loaded 28BYJ-48 loses steps
+// below roughly 700 us per full step, and the limit is angular velocity,
+// so it scales with the drive mode's step resolution
+#define MOTOR_FLOOR_PERIOD_US ((700 * 2048) / MOTOR_STEPS_PER_REV)
+
+// Per-motor state. target_steps is rewritten by motor_move_to while the
+// timer keeps running; the ISR re-reads it on every tick, so retargets
+// never stop and restart the timer.
+typedef struct {
+    const motor_config_t *cfg;
+    uint64_t next_due_us;        // Absolute step deadline on the shared timer
+    uint32_t ramp_min_period_us; // Effective cruise period after override/floor
+    int target_angle;
+    volatile int target_steps;   // Absolute step target, updatable mid-move
+    int ramp_steps_done;         // Steps since the move started, for the ramp
+    int direction;               // 1 or -1
+    volatile bool active;
+    int total_steps;             // Absolute position in steps from zero
+    // Pacing state: smoothed interval between accepted targets, and the
+    // per-move step period that spreads the move across that interval
+    uint32_t pace_period_us;     // 0 = unpaced, slew at the ramp's cruise
+    int64_t last_cmd_us;
+    uint32_t cmd_interval_us;
+    // Coil hold state: after a move the last phase pattern stays energized
+    // for CONFIG_MOTOR_HOLD_TIMEOUT_MS, then all four outputs drop low.
+    // The phase index derives from total_steps, so the next step
+    // re-energizes in the correct phase with no resync bookkeeping.
+    bool coils_on;
+    uint64_t release_due_us;     // When to de-energize, on the shared timer
+    uint32_t all_pins_mask;      // All four coil pins, for the release write
+    QueueHandle_t mailbox;
+    // Coil levels per sequence phase, precomputed at init as GPIO output
+    // register masks so the ISR drives all four pins with two register
+    // writes instead of four driver calls
+    uint32_t phase_set_mask[8];
+    uint32_t phase_clear_mask[8];
+    // Runtime calibration table: seeded from the compiled-in config,
+    // overridden by an NVS-stored table if one was uploaded (CAL: command)
+    cal_point_t cal_points[INSTRUMENT_MAX_CAL_POINTS];
+    int cal_count;
+    // Q16.16 slope of each calibration segment, precomputed whenever the
+    // table changes. The C3 has no FPU, so the old per-packet float
+    // interpolation was emulated in software; this reduces a lookup to one
+    // multiply and a shift.
+    int32_t cal_slope_q16[INSTRUMENT_MAX_CAL_POINTS - 1];
+} motor_t;
+
+static motor_t motors[INSTRUMENT_MAX_MOTORS];
+
+// One hardware timer drives every motor: the ISR steps whichever motors
+// are due and re-arms the alarm for the earliest next deadline, so
+// dual-motor instruments take one interrupt stream instead of two
+// uncorrelated ones. The mux serializes alarm updates between the ISR
+// and the command task.
+static gptimer_handle_t step_timer;
+static portMUX_TYPE step_mux = portMUX_INITIALIZER_UNLOCKED;
+
+int instrument_motor_min[INSTRUMENT_MAX_MOTORS];
+int instrument_motor_max[INSTRUMENT_MAX_MOTORS];
+
+static int norm360(int angle)
+{
+    angle = angle % 360;
+    if (angle < 0) angle += 360;
+    return angle;
+}
+
+int instrument_motor_angle(int motor_id)
+{
+    return (motors[motor_id].total_steps * 360) / MOTOR_STEPS_PER_REV;
+}
+
+// Convert a value to a motor angle using the motor's calibration points.
+// Interpolation uses the Q16.16 segment slopes precomputed when the table
+// was loaded: integer multiply and shift, no float math on the packet path.
+int instrument_value_to_angle(int motor_id, int value)
+{
+    const cal_point_t *calibration = motors[motor_id].cal_points;
+    int calibration_count = motors[motor_id].cal_count;
+
+    // Clamp to calibration range
+    if (value <= calibration[0].value) {
+        return calibration[0].angle;
+    }
+    if (value >= calibration[calibration_count - 1].value) {
+        return calibration[calibration_count - 1].angle;
+    }
+
+    // Find the segment containing the value (the tables have at most 11
+    // points, so the scan is a handful of compares)
+    int i = 1;
+    while (value > calibration[i].value) {
+        i++;
+    }
+
+    int32_t dv = value - calibration[i - 1].value;
+    return calibration[i - 1].angle +
+           (int)((dv * motors[motor_id].cal_slope_q16[i - 1] + (1 << 15)) >> 16);
+}
+
+#define CAL_NVS_NAMESPACE "calib"
+
+// Recompute the Q16.16 slope of each calibration segment
+static void cal_recompute_slopes(motor_t *m)
+{
+    for (int i = 0; i < m->cal_count - 1; i++) {
+        int32_t dv = m->cal_points[i + 1].value - m->cal_points[i].value;
+        int32_t da = m->cal_points[i + 1].angle - m->cal_points[i].angle;
+        m->cal_slope_q16[i] = (da << 16) / dv;
+    }
+}
+
+// A usable table has 2..16 points with strictly increasing values; the
+// slope division depends on non-zero value deltas
+static bool cal_valid(const cal_point_t *points, int count)
+{
+    if (count < 2 || count > INSTRUMENT_MAX_CAL_POINTS) {
+        return false;
+    }
+    for (int i = 1; i < count; i++) {
+        if (points[i].value <= points[i - 1].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void cal_nvs_key(int motor_id, char *key, size_t key_size)
+{
+    snprintf(key, key_size, "m%d", motor_id);
+}
+
+// Load a stored table over the compiled-in default, if one was uploaded.
+// The blob length carries the point count; a stale or corrupt blob is
+// ignored and the default stays in place.
+static void cal_nvs_load(int motor_id)
+{
+    motor_t *m = &motors[motor_id];
+    nvs_handle_t nvs;
+    if (nvs_open(CAL_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+
+    char key[8];
+    cal_nvs_key(motor_id, key, sizeof(key));
+
+    cal_point_t points[INSTRUMENT_MAX_CAL_POINTS];
+    size_t len = sizeof(points);
+    if (nvs_get_blob(nvs, key, points, &len) == ESP_OK &&
+        len % sizeof(cal_point_t) == 0) {
+        int count = len / sizeof(cal_point_t);
+        if (cal_valid(points, count)) {
+            memcpy(m->cal_points, points, len);
+            m->cal_count = count;
+            ESP_LOGI(TAG, "Motor %d: loaded %d-point calibration from NVS", motor_id, count);
+        } else {
+            ESP_LOGW(TAG, "Motor %d: stored calibration invalid, using built-in", motor_id);
+        }
+    }
+    nvs_close(nvs);
+}
+
+static void cal_nvs_save(int motor_id)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(CAL_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        ESP_LOGW(TAG, "Motor %d: cannot persist calibration", motor_id);
+        return;
+    }
+    char key[8];
+    cal_nvs_key(motor_id, key, sizeof(key));
+    nvs_set_blob(nvs, key, motors[motor_id].cal_points,
+                 motors[motor_id].cal_count * sizeof(cal_point_t));
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+// Called from the UDP receiver task, the same task that runs the
+// calibration lookup, so the table never changes under a lookup.
+bool instrument_motor_set_calibration(int motor_id, const cal_point_t *points, int count)
+{
+    if (!cal_valid(points, count)) {
+        ESP_LOGW(TAG, "Motor %d: rejecting calibration (%d points)", motor_id, count);
+        return false;
+    }
+
+    motor_t *m = &motors[motor_id];
+    memcpy(m->cal_points, points, count * sizeof(cal_point_t));
+    m->cal_count = count;
+    cal_recompute_slopes(m);
+    cal_nvs_save(motor_id);
+    ESP_LOGI(TAG, "Motor %d: calibration replaced, %d points (%d..%d)",
+             motor_id, count, points[0].value, points[count - 1].value);
+    return true;
+}
+
+// Alarm period for the next step: limited by the accelerate side (steps
+// done so far) and the decelerate side (steps remaining), clamped at cruise.
+static uint32_t motor_ramp_period(const motor_t *m, int steps_remaining)
+{
+    const motor_config_t *cfg = m->cfg;
+    int32_t accel = cfg->ramp_start_period_us - (int32_t)m->ramp_steps_done * cfg->ramp_step_us;
+    int32_t decel = cfg->ramp_start_period_us - (int32_t)(steps_remaining - 1) * cfg->ramp_step_us;
+    int32_t period = (accel > decel) ? accel : decel;
+    // The paced period (when a command stream is being tracked) overrides
+    // the cruise period; both are floors under the ramp
+    int32_t cruise = (int32_t)m->ramp_min_period_us;
+    if ((int32_t)m->pace_period_us > cruise) cruise = (int32_t)m->pace_period_us;
+    if (period < cruise) period = cruise;
+    return (uint32_t)period;
+}
+
+// Step one motor: direction and remaining steps are recomputed from the
+// current target on every tick, so a stream of retargets produces
+// continuous motion instead of stop-start jitter.
+static void motor_step(motor_t *m, uint64_t now)
+{
+    int remaining = m->target_steps - m->total_steps;
+    int direction = (remaining >= 0) ? 1 : -1;
+
+    // A retarget that reverses direction mid-move must not reverse the
+    // rotor at the cruise period: an open-loop stepper skips steps on an
+    // instant reversal and the position tracking is corrupt until the
+    // next ZERO. Restart the ramp instead and take the first reversed
+    // step one standstill-safe period from now.
+    if (direction != m->direction && m->ramp_steps_done > 0) {
+        m->direction = direction;
+        m->ramp_steps_done = 0;
+        m->next_due_us = now + m->cfg->ramp_start_period_us;
+#if CONFIG_PANEL_BENCHMARK
+        if (m == &motors[0]) bench_step_isr(0);  // Interval chain restarts
+#endif
+        return;
+    }
+    m->direction = direction;
+
+    // Perform one step: all four coil pins in two GPIO register writes
+    int seq_idx = m->total_steps % SEQUENCE_LEN;
+    if (seq_idx < 0) seq_idx += SEQUENCE_LEN;
+    GPIO.out_w1ts.val = m->phase_set_mask[seq_idx];
+    GPIO.out_w1tc.val = m->phase_clear_mask[seq_idx];
+    m->coils_on = true;
+
+    m->total_steps += m->direction;
+    m->ramp_steps_done++;
+    panel_counters.motor_steps++;
+    remaining = m->target_steps - m->total_steps;
+
+    if (remaining == 0) {
+        // Full-circle dials rotate continuously in one direction, so the
+        // absolute step counter would grow without bound and eventually
+        // overflow the degree conversion. Wrap it to one revolution at
+        // standstill; the offset is a multiple of the sequence length, so
+        // the coil phase is unchanged.
+        if (m->cfg->path_mode != MOTOR_PATH_CLAMP) {
+            int wrapped = m->total_steps % MOTOR_STEPS_PER_REV;
+            if (wrapped < 0) wrapped += MOTOR_STEPS_PER_REV;
+            m->total_steps = wrapped;
+            m->target_steps = wrapped;
+        }
+        m->active = false;
+#if CONFIG_MOTOR_HOLD_TIMEOUT_MS > 0
+        // Holding current is wasted on friction-held needles: schedule the
+        // coil release so an idle panel doesn't sit at full current
+        m->release_due_us = now + (uint64_t)CONFIG_MOTOR_HOLD_TIMEOUT_MS * 1000;
+#endif
+#if CONFIG_PANEL_BENCHMARK
+        if (m == &motors[0]) bench_step_isr(0);  // Interval chain restarts
+#endif
+        return;
+    }
+
+    uint32_t period = motor_ramp_period(m, abs(remaining));
+    m->next_due_us = now + period;
+#if CONFIG_PANEL_BENCHMARK
+    if (m == &motors[0]) bench_step_isr(period);
+#endif
+}
+
+// Timer interrupt handler, shared by all motors: next-deadline selection
+// over the motor states. Steps every motor that is due, then re-arms the
+// alarm for the earliest remaining deadline, so paired needles (pitch and
+// roll, rose and bug) interleave on one interrupt stream.
+static bool motor_timer_callback(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *user_ctx)
+{
+    portENTER_CRITICAL_ISR(&step_mux);
+
+    uint64_t now;
+    gptimer_get_raw_count(timer, &now);
+
+    uint64_t next_due = UINT64_MAX;
+    for (int id = 0; id < instrument_desc->motor_count; id++) {
+        motor_t *m = &motors[id];
+        if (m->active && m->next_due_us <= now) {
+            motor_step(m, now);
+        }
+        if (m->active) {
+            if (m->next_due_us < next_due) {
+                next_due = m->next_due_us;
+            }
+#if CONFIG_MOTOR_HOLD_TIMEOUT_MS > 0
+        } else if (m->coils_on) {
+            // Idle with coils energized: release at the hold deadline
+            if (m->release_due_us <= now) {
+                GPIO.out_w1tc.val = m->all_pins_mask;
+                m->coils_on = false;
+            } else if (m->release_due_us < next_due) {
+                next_due = m->release_due_us;
+            }
+#endif
+        }
+    }
+
+    if (next_due != UINT64_MAX) {
+        // Guard against arming in the past: the 64-bit counter never
+        // wraps, so a missed alarm would stall the motor forever
+        uint64_t now2;
+        gptimer_get_raw_count(timer, &now2);
+        if (next_due <= now2 + 1) {
+            next_due = now2 + 5;
+            panel_counters.isr_overruns++;
+        }
+        gptimer_alarm_config_t alarm_config = {
+            .alarm_count = next_due,
+            .flags.auto_reload_on_alarm = false,
+        };
+        gptimer_set_alarm_action(timer, &alarm_config);
+    }
+
+    portEXIT_CRITICAL_ISR(&step_mux);
+    return false;
+}
+
+static void motor_move_to(int motor_id, int target_angle, int min_angle, int max_angle)
+{
+    motor_t *m = &motors[motor_id];
+    const motor_config_t *cfg = m->cfg;
+
+    if (cfg->reject_out_of_bounds) {
+        if (target_angle < min_angle || target_angle > max_angle) {
+            PANEL_HOT_LOGW(TAG, "Motor %d: Rejecting out-of-bounds angle %d° (valid range: %d°-%d°)",
+                     motor_id, target_angle, min_angle, max_angle);
+            return;
+        }
+    } else {
+        if (target_angle < min_angle) target_angle = min_angle;
+        if (target_angle > max_angle) target_angle = max_angle;
+    }
+
+    // Compute the absolute step target according to the motor's path mode
+    int target_steps;
+    switch (cfg->path_mode) {
+        case MOTOR_PATH_WRAP_SHORTEST: {
+            // 0-360 dial: take the shortest way around
+            int current_norm = norm360(instrument_motor_angle(motor_id));
+            int diff = norm360(target_angle) - current_norm;
+            if (diff > 180) diff -= 360;
+            else if (diff < -180) diff += 360;
+            target_steps = m->total_steps + (diff * MOTOR_STEPS_PER_REV) / 360;
+            break;
+        }
+        case MOTOR_PATH_WRAP_AVOID: {
+            // 0-360 dial with a forbidden gap: if the direct path would
+            // cross avoid_angle, go the other way around
+            int current_norm = norm360(instrument_motor_angle(motor_id));
+            int diff = target_angle - current_norm;
+            if (diff > 0 && current_norm < cfg->avoid_angle && target_angle > cfg->avoid_angle) {
+                diff -= 360;
+            } else if (diff < 0 && current_norm > cfg->avoid_angle && target_angle < cfg->avoid_angle) {
+                diff += 360;
+            }
+            target_steps = m->total_steps + (diff * MOTOR_STEPS_PER_REV) / 360;
+            break;
+        }
+        case MOTOR_PATH_CLAMP:
+        default:
+            target_steps = (target_angle * MOTOR_STEPS_PER_REV) / 360;
+            break;
+    }
+
+    int diff_steps = target_steps - m->total_steps;
+
+#if CONFIG_MOTOR_INTERPOLATE
+    // Pace the move to the command stream: X-Plane sends discrete jumps,
+    // and slewing to each at full speed then stopping dead reads as
+    // lurching. Spreading the steps across the (smoothed) inter-command
+    // interval makes the needle arrive just as the next target is due.
+    int64_t cmd_us = esp_timer_get_time();
+    m->pace_period_us = 0;
+    if (m->last_cmd_us != 0) {
+        int64_t gap = cmd_us - m->last_cmd_us;
+        if (gap > 0 && gap < 2000000) {
+            m->cmd_interval_us = m->cmd_interval_us
+                ? (3 * m->cmd_interval_us + (uint32_t)gap) / 4
+                : (uint32_t)gap;
+            if (diff_steps != 0) {
+                uint32_t pace = m->cmd_interval_us / (uint32_t)abs(diff_steps);
+                if (pace > MOTOR_PACE_MAX_PERIOD_US) pace = MOTOR_PACE_MAX_PERIOD_US;
+                if (pace > m->ramp_min_period_us) m->pace_period_us = pace;
+            }
+        } else {
+            m->cmd_interval_us = 0;  // Stream gap, restart the estimate
+        }
+    }
+    m->last_cmd_us = cmd_us;
+#endif
+
+    if (diff_steps == 0 && !m->active) {
+        PANEL_HOT_LOGI(TAG, "Motor %d already at target: %d°", motor_id, target_angle);
+        return;
+    }
+
+    PANEL_HOT_LOGI(TAG, "Motor %d START: current=%d° (%d steps), target=%d° (%d steps), diff=%d steps, dir=%s",
+             motor_id, instrument_motor_angle(motor_id), m->total_steps, target_angle, target_steps,
+             diff_steps, (diff_steps >= 0) ? "CW" : "CCW");
+
+    // The ISR's completion path rewrites total_steps and target_steps
+    // when it wraps a full-circle dial back into one revolution, so the
+    // target write and the in-flight check must be atomic against it,
+    // and a wrap-mode target must be re-based on the live counter: a
+    // target computed from the pre-wrap snapshot above would be whole
+    // revolutions away from the wrapped position, spinning the dial the
+    // long way around (and across any forbidden gap).
+    portENTER_CRITICAL(&step_mux);
+    if (cfg->path_mode != MOTOR_PATH_CLAMP) {
+        target_steps = m->total_steps + diff_steps;
+    }
+    m->target_angle = target_angle;
+    m->target_steps = target_steps;
+    diff_steps = target_steps - m->total_steps;
+    bool in_flight = m->active;
+    portEXIT_CRITICAL(&step_mux);
+
+    // If a move is already in flight, the ISR picks up the new target on
+    // its next tick -- the timer keeps running, so a continuous stream of
+    // retargets produces continuous motion with no stop/start hitch
+    if (in_flight) {
+        return;
+    }
+
+    // Starting from standstill: reset the ramp and begin at the safe period
+    m->ramp_steps_done = 0;
+    m->direction = (diff_steps >= 0) ? 1 : -1;
+
+#if CONFIG_PANEL_BENCHMARK
+    bench_command_armed();
+#endif
+
+    // Schedule this motor's first step and pull the alarm forward if it
+    // is now the earliest deadline. The critical section keeps the ISR
+    // from re-arming the alarm between our read and write.
+    portENTER_CRITICAL(&step_mux);
+    uint64_t now;
+    gptimer_get_raw_count(step_timer, &now);
+    m->next_due_us = now + cfg->ramp_start_period_us;
+    m->active = true;
+
+    uint64_t next_due = UINT64_MAX;
+    for (int id = 0; id < instrument_desc->motor_count; id++) {
+        if (motors[id].active && motors[id].next_due_us < next_due) {
+            next_due = motors[id].next_due_us;
+        }
+#if CONFIG_MOTOR_HOLD_TIMEOUT_MS > 0
+        if (!motors[id].active && motors[id].coils_on &&
+            motors[id].release_due_us < next_due) {
+            next_due = motors[id].release_due_us;
+        }
+#endif
+    }
+    // Same past-guard as the ISR: another motor's deadline may have
+    // elapsed while we were computing, and a missed alarm never fires
+    uint64_t now2;
+    gptimer_get_raw_count(step_timer, &now2);
+    if (next_due <= now2 + 1) {
+        next_due = now2 + 5;
+    }
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = next_due,
+        .flags.auto_reload_on_alarm = false,
+    };
+    gptimer_set_alarm_action(step_timer, &alarm_config);
+    portEXIT_CRITICAL(&step_mux);
+}
+
+void instrument_motor_zero(int motor_id, int zero_angle)
+{
+    motor_t *m = &motors[motor_id];
+    m->active = false;
+    m->total_steps = (zero_angle * MOTOR_STEPS_PER_REV) / 360;
+    m->target_steps = m->total_steps;
+    m->target_angle = zero_angle;
+    ESP_LOGI(TAG, "Motor %d zeroed to %d degrees", motor_id, zero_angle);
+}
+
+// Single-slot mailbox between the UDP receiver and the motor layer. The
+// receiver overwrites the slot on every command, so when X-Plane streams
+// targets faster than the needle can move, the motor always chases the
+// newest target and stale intermediate targets are dropped.
+void instrument_motor_command(int motor_id, int target_angle, int min_angle, int max_angle)
+{
+    // Dead-band: X-Plane values jitter by fractions of a unit every frame,
+    // and chasing every wobble keeps the motor chattering around its
+    // target. Targets within the dead-band of the last commanded angle are
+    // dropped before they ever touch the mailbox.
+#if CONFIG_MOTOR_DEADBAND_DEG > 0
+    int delta = target_angle - motors[motor_id].target_angle;
+    if (delta < 0) delta = -delta;
+    if (delta <= CONFIG_MOTOR_DEADBAND_DEG) {
+        return;  // Repeat of the current target counts too
+    }
+#endif
+
+    motor_cmd_t cmd = {
+        .motor_id = motor_id,
+        .target_angle = target_angle,
+        .min_angle = min_angle,
+        .max_angle = max_angle,
+    };
+    xQueueOverwrite(motors[motor_id].mailbox, &cmd);
+}
+
+static void motor_command_task(void *pvParameters)
+{
+    int motor_id = (int)(intptr_t)pvParameters;
+    motor_cmd_t cmd;
+
+    while (1) {
+        if (xQueueReceive(motors[motor_id].mailbox, &cmd, portMAX_DELAY) == pdTRUE) {
+            motor_move_to(cmd.motor_id, cmd.target_angle, cmd.min_angle, cmd.max_angle);
+            // Retarget rate limit: sleeping here paces how often the move
+            // path runs while the single-slot mailbox keeps coalescing, so
+            // the newest target is never lost, just applied a tick later
+#if CONFIG_MOTOR_RETARGET_MIN_MS > 0
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_MOTOR_RETARGET_MIN_MS));
+#endif
+        }
+    }
+}
+
+void motor_engine_init(void)
+{
+    for (int m = 0; m < instrument_desc->motor_count; m++) {
+        const motor_config_t *cfg = &instrument_desc->motors[m];
+        motors[m].cfg = cfg;
+
+        // Effective cruise period: menuconfig override when set, clamped
+        // to the stall-safe floor and to the standstill-safe start period
+        uint32_t cruise = cfg->ramp_min_period_us;
+        if (CONFIG_MOTOR_CRUISE_PERIOD_US > 0) {
+            cruise = CONFIG_MOTOR_CRUISE_PERIOD_US;
+        }
+        if (cruise < MOTOR_FLOOR_PERIOD_US) {
+            ESP_LOGW(TAG, "Motor %d: cruise period %lu us below stall floor, using %d us",
+                     m, (unsigned long)cruise, MOTOR_FLOOR_PERIOD_US);
+            cruise = MOTOR_FLOOR_PERIOD_US;
+        }
+        if (cruise > cfg->ramp_start_period_us) {
+            cruise = cfg->ramp_start_period_us;
+        }
+        motors[m].ramp_min_period_us = cruise;
+
+        gpio_config_t io_conf = {
+            .pin_bit_mask = (1ULL << cfg->pin_in1) | (1ULL << cfg->pin_in2) |
+                            (1ULL << cfg->pin_in3) | (1ULL << cfg->pin_in4),
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+        gpio_config(&io_conf);
+        gpio_set_level(cfg->pin_in1, 0);
+        gpio_set_level(cfg->pin_in2, 0);
+        gpio_set_level(cfg->pin_in3, 0);
+        gpio_set_level(cfg->pin_in4, 0);
+
+        // Precompute the per-phase set/clear masks, folding in any coil
+        // order reversal, so the ISR never walks the sequence table
+        int pins[4] = {cfg->pin_in1, cfg->pin_in2, cfg->pin_in3, cfg->pin_in4};
+        if (cfg->reverse_pins) {
+            pins[0] = cfg->pin_in4;
+            pins[1] = cfg->pin_in3;
+            pins[2] = cfg->pin_in2;
+            pins[3] = cfg->pin_in1;
+        }
+        for (int s = 0; s < SEQUENCE_LEN; s++) {
+            uint32_t set_mask = 0, clear_mask = 0;
+            for (int c = 0; c < 4; c++) {
+                if (SEQUENCE[s][c]) {
+                    set_mask |= (1UL << pins[c]);
+                } else {
+                    clear_mask |= (1UL << pins[c]);
+                }
+            }
+            motors[m].phase_set_mask[s] = set_mask;
+            motors[m].phase_clear_mask[s] = clear_mask;
+        }
+        motors[m].all_pins_mask = (1UL << cfg->pin_in1) | (1UL << cfg->pin_in2) |
+                                  (1UL << cfg->pin_in3) | (1UL << cfg->pin_in4);
+
+        // Seed the runtime calibration from the compiled-in table, then
+        // let an uploaded table stored in NVS override it
+        motors[m].cal_count = cfg->calibration_count;
+        if (motors[m].cal_count > INSTRUMENT_MAX_CAL_POINTS) {
+            motors[m].cal_count = INSTRUMENT_MAX_CAL_POINTS;
+        }
+        memcpy(motors[m].cal_points, cfg->calibration,
+               motors[m].cal_count * sizeof(cal_point_t));
+        cal_nvs_load(m);
+        cal_recompute_slopes(&motors[m]);
+
+        // Don't move the needle on startup - just set internal position
+        instrument_motor_zero(m, cfg->zero_angle);
+        instrument_motor_min[m] = cfg->min_angle;
+        instrument_motor_max[m] = cfg->max_angle;
+    }
+
+    // One shared hardware timer for all motors; the ISR schedules the
+    // interleaved step deadlines
+    if (instrument_desc->motor_count > 0) {
+        gptimer_config_t timer_config = {
+            .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+            .direction = GPTIMER_COUNT_UP,
+            .resolution_hz = 1000000,  // 1 MHz for microsecond precision
+        };
+        ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &step_timer));
+
+        gptimer_event_callbacks_t cbs = {
+            .on_alarm = motor_timer_callback,
+        };
+        ESP_ERROR_CHECK(gptimer_register_event_callbacks(step_timer, &cbs, NULL));
+        ESP_ERROR_CHECK(gptimer_enable(step_timer));
+        // Started here, once, and left free-running with no alarm armed.
+        // Starting it lazily on the first command raced: a bundle wakes
+        // both command tasks at once, and gptimer_start on an already
+        // running timer aborts via ESP_ERROR_CHECK.
+        ESP_ERROR_CHECK(gptimer_set_raw_count(step_timer, 0));
+        ESP_ERROR_CHECK(gptimer_start(step_timer));
+    }
+
+    ESP_LOGI(TAG, "%d motor(s) on shared step timer", instrument_desc->motor_count);
+}
+
+void motor_engine_start_tasks(void)
+{
+    for (int m = 0; m < instrument_desc->motor_count; m++) {
+        motors[m].mailbox = xQueueCreate(1, sizeof(motor_cmd_t));
+        xTaskCreate(motor_command_task, "motor_cmd", 2048, (void *)(intptr_t)m, 4, NULL);
+    }
+}
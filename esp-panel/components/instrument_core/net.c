@@ -0,0 +1,816 @@
+/* WiFi, heartbeat, remote logging and the UDP command receiver.
+ *
+ * The receiver prefers the binary frames from panel_proto.h and falls back
+ * to the text protocol ("VALUE:", "ANGLE:", "MOVE:", "ZERO:", "BOUNDS:",
+ * "CAL:")
+ * used by the web server calibration tools. Commands are dispatched through
+ * the instrument's hooks when it has them, otherwise through the shared
+ * calibration lookup.
+ *
+ * With XPLANE_DIRECT enabled the command PCB additionally subscribes to
+ * X-Plane's RREF stream and feeds the responses straight into the VALUE
+ * dispatch, cutting the hub out of the latency-critical path; the hub
+ * keeps handling calibration, heartbeats and the web dashboard.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_task_wdt.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "nvs_flash.h"
+#include "lwip/sockets.h"
+#include "lwip/netif.h"
+#include "lwip/udp.h"
+#include "lwip/igmp.h"
+#include "lwip/tcpip.h"
+#include "sdkconfig.h"
+#include "panel_proto.h"
+#include "instrument_internal.h"
+
+static const char *TAG = "udp_receiver";
+#define UDP_PORT       49003
+#define HEARTBEAT_PORT 49002
+#define BUFFER_SIZE    1024
+#define HEARTBEAT_INTERVAL 5000
+#define LOG_PORT       9999
+
+#define WIFI_SSID      CONFIG_WIFI_SSID
+#define WIFI_PASS      CONFIG_WIFI_PASSWORD
+#define RPI_IP         CONFIG_RPI_IP_ADDRESS
+#define ESP_ID         CONFIG_ESP_DEVICE_ID
+
+// Older Kconfig.projbuild copies may predate the static IP options
+#ifndef CONFIG_STATIC_IP_ADDRESS
+#define CONFIG_STATIC_IP_ADDRESS ""
+#define CONFIG_STATIC_GATEWAY    ""
+#define CONFIG_STATIC_NETMASK    "255.255.255.0"
+#endif
+
+static int log_socket = -1;
+static char esp_ip_addr[32] = "";
+
+// Command PCB, created in the lwIP thread by udp_receiver_start. Direct
+// X-Plane mode sends its RREF subscriptions from this PCB so the
+// responses arrive on the command port and share the receive path.
+static struct udp_pcb *command_pcb;
+
+#if CONFIG_XPLANE_DIRECT
+// X-Plane RREF subscription: "RREF\0" + requested rate (Hz) + client
+// index + 400-byte dataref path, sent to the simulator's command port.
+// Responses come back as "RREF," followed by (index, float) records.
+// The subscription index doubles as our motor id.
+#define XPLANE_PORT           49000
+#define XPLANE_RREF_REQ_LEN   (5 + 4 + 4 + 400)
+#define XPLANE_RREF_REC_LEN   8
+
+static const char *xplane_drefs[INSTRUMENT_MAX_MOTORS] = {
+    CONFIG_XPLANE_DREF_MOTOR0,
+#if INSTRUMENT_MAX_MOTORS > 1
+    CONFIG_XPLANE_DREF_MOTOR1,
+#endif
+};
+static const int xplane_scales[INSTRUMENT_MAX_MOTORS] = {
+    CONFIG_XPLANE_DREF_MOTOR0_SCALE,
+#if INSTRUMENT_MAX_MOTORS > 1
+    CONFIG_XPLANE_DREF_MOTOR1_SCALE,
+#endif
+};
+
+static void xplane_subscribe(void *ctx);
+#endif // CONFIG_XPLANE_DIRECT
+
+static EventGroupHandle_t wifi_event_group;
+#define WIFI_GOT_IP_BIT BIT0
+
+panel_counters_t panel_counters;
+
+// Last association's BSSID and channel, cached in NVS so the next boot can
+// associate directly instead of scanning every channel first
+#define FASTCONN_NVS_NAMESPACE "fastconn"
+
+static void fastconn_save(void)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+
+    nvs_handle_t nvs;
+    if (nvs_open(FASTCONN_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+
+    uint8_t stored_bssid[6] = {0};
+    size_t len = sizeof(stored_bssid);
+    uint8_t stored_channel = 0;
+    nvs_get_blob(nvs, "bssid", stored_bssid, &len);
+    nvs_get_u8(nvs, "channel", &stored_channel);
+
+    // Only write flash when the AP actually changed
+    if (memcmp(stored_bssid, ap.bssid, 6) != 0 || stored_channel != ap.primary) {
+        nvs_set_blob(nvs, "bssid", ap.bssid, 6);
+        nvs_set_u8(nvs, "channel", ap.primary);
+        nvs_commit(nvs);
+        ESP_LOGI(TAG, "Cached AP for fast reconnect (channel %d)", ap.primary);
+    }
+    nvs_close(nvs);
+}
+
+static bool fastconn_load(uint8_t bssid[6], uint8_t *channel)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(FASTCONN_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+
+    size_t len = 6;
+    bool ok = (nvs_get_blob(nvs, "bssid", bssid, &len) == ESP_OK && len == 6 &&
+               nvs_get_u8(nvs, "channel", channel) == ESP_OK);
+    nvs_close(nvs);
+    return ok;
+}
+
+static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        // If the cached BSSID no longer answers (AP replaced or moved to
+        // another channel), fall back to a full scan after a few failures
+        static int fail_count = 0;
+        if (++fail_count == 3) {
+            wifi_config_t wifi_config;
+            if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK && wifi_config.sta.bssid_set) {
+                wifi_config.sta.bssid_set = false;
+                wifi_config.sta.channel = 0;
+                esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+                ESP_LOGW(TAG, "Cached AP not responding, falling back to full scan");
+            }
+        }
+        ESP_LOGI(TAG, "Disconnected, reconnecting...");
+        esp_wifi_connect();
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+        ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        snprintf(esp_ip_addr, sizeof(esp_ip_addr), IPSTR, IP2STR(&event->ip_info.ip));
+        oled_show_ip(esp_ip_addr);
+        fastconn_save();
+        xEventGroupSetBits(wifi_event_group, WIFI_GOT_IP_BIT);
+    }
+}
+
+// Blocks until the interface has an address, or the timeout expires so the
+// firmware still comes up (with logging and heartbeats retrying) when the
+// AP is down. Replaces the old fixed 5-second post-init sleep.
+bool net_wait_for_ip(int timeout_ms)
+{
+    EventBits_t bits = xEventGroupWaitBits(wifi_event_group, WIFI_GOT_IP_BIT,
+                                           pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & WIFI_GOT_IP_BIT) != 0;
+}
+
+void wifi_init(void)
+{
+    wifi_event_group = xEventGroupCreate();
+
+    // NVS is initialized by instrument_core_start before the motor engine,
+    // which needs it for stored calibration tables
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_t *netif = esp_netif_create_default_wifi_sta();
+
+    // Static IP (when configured) skips the DHCP round-trip on every boot
+    if (CONFIG_STATIC_IP_ADDRESS[0] != '\0') {
+        esp_netif_dhcpc_stop(netif);
+        esp_netif_ip_info_t ip_info = {0};
+        ip_info.ip.addr = ipaddr_addr(CONFIG_STATIC_IP_ADDRESS);
+        ip_info.gw.addr = ipaddr_addr(CONFIG_STATIC_GATEWAY);
+        ip_info.netmask.addr = ipaddr_addr(CONFIG_STATIC_NETMASK);
+        ESP_ERROR_CHECK(esp_netif_set_ip_info(netif, &ip_info));
+        ESP_LOGI(TAG, "Static IP configured: %s", CONFIG_STATIC_IP_ADDRESS);
+    }
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
+
+    wifi_config_t wifi_config = {0};
+    strncpy((char *)wifi_config.sta.ssid, WIFI_SSID, sizeof(wifi_config.sta.ssid) - 1);
+    strncpy((char *)wifi_config.sta.password, WIFI_PASS, sizeof(wifi_config.sta.password) - 1);
+
+    // With a cached BSSID and channel the station associates directly
+    // instead of scanning every channel; the cache is refreshed on every
+    // successful connection, so a moved AP costs one slow boot
+    uint8_t bssid[6];
+    uint8_t channel = 0;
+    if (fastconn_load(bssid, &channel)) {
+        memcpy(wifi_config.sta.bssid, bssid, 6);
+        wifi_config.sta.bssid_set = true;
+        wifi_config.sta.channel = channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+        ESP_LOGI(TAG, "Fast reconnect: cached AP on channel %d", channel);
+    }
+
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_start());
+}
+
+// Log lines are staged in a ring buffer and shipped by a low-priority
+// drain task. The old implementation did a blocking send() per line from
+// whatever task was logging, so a stalled log client back-pressured the
+// UDP receiver and the motor command path; now the producer side is a
+// bounded copy under a short critical section and can never wait on the
+// network. When the ring is full the line is dropped and counted.
+#define LOG_RING_SIZE 8192
+#define LOG_LINE_MAX  256
+
+static char log_ring[LOG_RING_SIZE];
+static volatile int log_ring_head = 0;  // Producer index
+static volatile int log_ring_tail = 0;  // Consumer index (drain task only)
+static volatile uint32_t log_dropped = 0;
+static portMUX_TYPE log_ring_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static int wifi_log_vprintf(const char *fmt, va_list args)
+{
+    char line[LOG_LINE_MAX];
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    if (len <= 0) {
+        return len;
+    }
+    if (len >= (int)sizeof(line)) {
+        len = sizeof(line) - 1;  // Truncated, keep what fits
+    }
+
+    portENTER_CRITICAL(&log_ring_mux);
+    int used = log_ring_head - log_ring_tail;
+    if (used < 0) used += LOG_RING_SIZE;
+
+    // Leave one byte free so head == tail always means empty
+    if (used + len >= LOG_RING_SIZE) {
+        log_dropped++;
+        panel_counters.log_dropped++;
+    } else {
+        int head = log_ring_head;
+        int first = LOG_RING_SIZE - head;
+        if (first > len) first = len;
+        memcpy(&log_ring[head], line, first);
+        if (len > first) {
+            memcpy(&log_ring[0], line + first, len - first);
+        }
+        log_ring_head = (head + len) % LOG_RING_SIZE;
+    }
+    portEXIT_CRITICAL(&log_ring_mux);
+
+    return len;
+}
+
+// Drains the ring to the connected log client. Runs at the lowest task
+// priority so it only uses cycles the receive and motor paths don't want.
+// With no client connected the ring is discarded instead of filling up.
+static void log_drain_task(void *pvParameters)
+{
+    char chunk[LOG_LINE_MAX];
+
+    while (1) {
+        int head = log_ring_head;
+        int tail = log_ring_tail;
+
+        if (head == tail) {
+            uint32_t dropped = log_dropped;
+            if (dropped > 0 && log_socket >= 0) {
+                log_dropped = 0;
+                int n = snprintf(chunk, sizeof(chunk), "[log: %lu lines dropped]\n", (unsigned long)dropped);
+                send(log_socket, (uint8_t *)chunk, n, 0);
+            }
+            vTaskDelay(pdMS_TO_TICKS(20));
+            continue;
+        }
+
+        int avail = head - tail;
+        if (avail < 0) avail = LOG_RING_SIZE - tail;  // Up to the wrap point
+        if (avail > (int)sizeof(chunk)) avail = sizeof(chunk);
+
+        if (log_socket >= 0) {
+            send(log_socket, (uint8_t *)&log_ring[tail], avail, 0);
+        }
+        log_ring_tail = (tail + avail) % LOG_RING_SIZE;
+    }
+}
+
+static void wifi_logging_task(void *pvParameters)
+{
+    struct sockaddr_in server_addr;
+    int server_socket;
+
+    server_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (server_socket < 0) {
+        ESP_LOGE(TAG, "Failed to create log server socket");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    int opt = 1;
+    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    server_addr.sin_port = htons(LOG_PORT);
+
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        ESP_LOGE(TAG, "Failed to bind log server socket");
+        close(server_socket);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    listen(server_socket, 1);
+    ESP_LOGI(TAG, "WiFi logging server listening on port %d", LOG_PORT);
+
+    while (1) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+
+        int client_socket = accept(server_socket, (struct sockaddr *)&client_addr, &client_len);
+        if (client_socket >= 0) {
+            log_socket = client_socket;
+            ESP_LOGI(TAG, "WiFi logging client connected: %s", inet_ntoa(client_addr.sin_addr));
+
+            // Keep connection open until client disconnects
+            char dummy[256];
+            while (recv(client_socket, dummy, sizeof(dummy), 0) > 0) {
+                vTaskDelay(pdMS_TO_TICKS(100));
+            }
+
+            ESP_LOGI(TAG, "WiFi logging client disconnected");
+            close(client_socket);
+            log_socket = -1;
+        }
+    }
+}
+
+void net_logging_start(void)
+{
+    // Start WiFi logging before other tasks
+    xTaskCreate(wifi_logging_task, "wifi_log", 4096, NULL, 2, NULL);
+    xTaskCreate(log_drain_task, "log_drain", 2048, NULL, 1, NULL);
+    vTaskDelay(500 / portTICK_PERIOD_MS);
+    esp_log_set_vprintf(wifi_log_vprintf);
+}
+
+static void heartbeat_task(void *pvParameters)
+{
+    esp_task_wdt_add(NULL);
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+
+    struct sockaddr_in dest_addr;
+    dest_addr.sin_addr.s_addr = inet_addr((const char *)RPI_IP);
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(HEARTBEAT_PORT);
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create heartbeat socket");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Heartbeat task started, sending to %s:%d", RPI_IP, HEARTBEAT_PORT);
+
+    char heartbeat_msg[64];
+    int heartbeat_count = 0;
+
+    while (1) {
+        esp_task_wdt_reset();
+        uint32_t uptime = xTaskGetTickCount() * portTICK_PERIOD_MS / 1000;
+        snprintf(heartbeat_msg, sizeof(heartbeat_msg), "HEARTBEAT:%s:%lu", ESP_ID, (unsigned long)uptime);
+
+        int ret = sendto(sock, heartbeat_msg, strlen(heartbeat_msg), 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+        if (ret < 0) {
+            ESP_LOGW(TAG, "Heartbeat send failed: errno %d, to %s:%d", errno, RPI_IP, HEARTBEAT_PORT);
+        } else {
+            heartbeat_count++;
+            if (heartbeat_count % 6 == 0) {  // Log every 30 seconds (6 x 5 second intervals)
+                ESP_LOGI(TAG, "Heartbeat sent (%d sent, msg: %s)", heartbeat_count, heartbeat_msg);
+            }
+        }
+
+#if CONFIG_XPLANE_DIRECT
+        // Refresh the RREF subscriptions so a restarted simulator
+        // resumes the stream without anyone touching the panel
+        if (command_pcb != NULL) {
+            tcpip_callback(xplane_subscribe, NULL);
+        }
+#endif
+
+        esp_task_wdt_reset();
+        vTaskDelay(HEARTBEAT_INTERVAL / portTICK_PERIOD_MS);
+    }
+}
+
+static bool motor_id_valid(int motor_id)
+{
+    return motor_id >= 0 && motor_id < instrument_desc->motor_count;
+}
+
+// VALUE: run the instrument hook first; if it declines, fall back to the
+// shared calibration lookup on the addressed motor
+static void handle_value(int motor_id, int value)
+{
+    if (!motor_id_valid(motor_id)) return;
+
+    if (instrument_desc->on_value && instrument_desc->on_value(motor_id, value)) {
+        return;
+    }
+
+    int angle = instrument_value_to_angle(motor_id, value);
+    instrument_motor_command(motor_id, angle, instrument_motor_min[motor_id], instrument_motor_max[motor_id]);
+}
+
+static void handle_zero(int motor_id)
+{
+    if (!motor_id_valid(motor_id)) return;
+
+    if (instrument_desc->on_zero) {
+        instrument_desc->on_zero(motor_id);
+        return;
+    }
+
+    instrument_motor_zero(motor_id, instrument_desc->motors[motor_id].zero_angle);
+}
+
+// Multicast bundle: pick out the entries addressed to this device and
+// dispatch them like VALUE commands
+static void handle_bundle(const char *buf, int len)
+{
+    const panel_bundle_t *bundle = (const panel_bundle_t *)buf;
+    if (len != (int)(sizeof(panel_bundle_t) + bundle->count * sizeof(panel_bundle_entry_t))) {
+        panel_counters.rx_errors++;
+        return;
+    }
+
+    for (int i = 0; i < bundle->count; i++) {
+        const panel_bundle_entry_t *entry = &bundle->entries[i];
+        if (strncmp(entry->esp_id, ESP_ID, sizeof(entry->esp_id)) == 0) {
+            handle_value(entry->motor_id, entry->value);
+        }
+    }
+}
+
+#if CONFIG_XPLANE_DIRECT
+// RREF response: "RREF," then 8-byte records of little-endian int32 index
+// and float value. The index is the motor id we subscribed with. One
+// soft-float multiply per record (the C3 has no FPU) is the whole
+// conversion cost at 30-60 Hz; the result feeds the same integer VALUE
+// path the hub would have used.
+static void handle_rref(const char *buf, int len)
+{
+    for (int off = 5; off + XPLANE_RREF_REC_LEN <= len; off += XPLANE_RREF_REC_LEN) {
+        int32_t idx;
+        float raw;
+        memcpy(&idx, buf + off, sizeof(idx));
+        memcpy(&raw, buf + off + 4, sizeof(raw));
+
+        if (idx < 0 || idx >= instrument_desc->motor_count) {
+            continue;
+        }
+        float scaled = raw * (float)xplane_scales[idx];
+        handle_value(idx, (int)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f));
+    }
+}
+
+// Sends one RREF subscription per configured motor dataref. Runs in the
+// lwIP thread (tcpip_callback). Re-sent with every heartbeat: the
+// requests are idempotent, and a restarted simulator picks the stream
+// back up within one interval.
+static void xplane_subscribe(void *ctx)
+{
+    if (command_pcb == NULL) {
+        return;
+    }
+
+    ip_addr_t xp_addr;
+    if (!ipaddr_aton(CONFIG_XPLANE_IP_ADDRESS, &xp_addr)) {
+        ESP_LOGE(TAG, "Invalid X-Plane address: %s", CONFIG_XPLANE_IP_ADDRESS);
+        return;
+    }
+
+    for (int i = 0; i < instrument_desc->motor_count; i++) {
+        if (xplane_drefs[i][0] == '\0') {
+            continue;
+        }
+
+        struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, XPLANE_RREF_REQ_LEN, PBUF_RAM);
+        if (p == NULL) {
+            return;
+        }
+        char *req = (char *)p->payload;
+        memset(req, 0, XPLANE_RREF_REQ_LEN);
+        memcpy(req, "RREF", 5);  // includes the NUL
+        int32_t rate = CONFIG_XPLANE_RREF_RATE;
+        int32_t idx = i;
+        memcpy(req + 5, &rate, sizeof(rate));
+        memcpy(req + 9, &idx, sizeof(idx));
+        strncpy(req + 13, xplane_drefs[i], 400 - 1);
+
+        udp_sendto(command_pcb, p, &xp_addr, XPLANE_PORT);
+        pbuf_free(p);
+    }
+}
+#endif // CONFIG_XPLANE_DIRECT
+
+// Binary command dispatch: same actions as the text handlers below, minus
+// the per-packet logging that dominates the receive path at 30-60 Hz.
+static void handle_binary_frame(const panel_frame_t *frame)
+{
+    switch (frame->opcode) {
+        case PANEL_OP_VALUE:
+            handle_value(frame->motor_id, frame->value);
+            break;
+        case PANEL_OP_ANGLE:
+            if (motor_id_valid(frame->motor_id)) {
+                instrument_motor_command(frame->motor_id, frame->value,
+                                         instrument_motor_min[frame->motor_id],
+                                         instrument_motor_max[frame->motor_id]);
+            }
+            break;
+        case PANEL_OP_MOVE:
+            if (motor_id_valid(frame->motor_id)) {
+                int min_angle = frame->min_angle;
+                int max_angle = frame->max_angle;
+                // The web tools send 0-360 when they mean "whatever the
+                // instrument allows"; substitute the runtime bounds
+                if (min_angle == 0 && max_angle == 360) {
+                    min_angle = instrument_motor_min[frame->motor_id];
+                    max_angle = instrument_motor_max[frame->motor_id];
+                }
+                instrument_motor_command(frame->motor_id, frame->value, min_angle, max_angle);
+            }
+            break;
+        case PANEL_OP_ZERO:
+            handle_zero(frame->motor_id);
+            break;
+        case PANEL_OP_VALUE2:
+            // Both motors in one datagram: dispatch back to back so paired
+            // axes (pitch/roll) start moving in the same instant
+            handle_value(0, frame->value);
+            handle_value(1, frame->min_angle);
+            break;
+    }
+}
+
+// Text command dispatch: the fallback protocol used by the web tools.
+// rx_buffer is NUL-terminated by the caller.
+static void dispatch_text(char *rx_buffer)
+{
+    panel_counters.rx_text++;
+    PANEL_HOT_LOGI(TAG, "Received: %s", rx_buffer);
+
+    if (strncmp(rx_buffer, "VALUE:", 6) == 0) {
+        int motor_id = 0, value = 0;
+        if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &value) == 2 || sscanf(&rx_buffer[6], "%d", &value) == 1) {
+            if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &value) != 2) {
+                motor_id = 0;  // Default to motor 0 if not specified
+            }
+            PANEL_HOT_LOGI(TAG, "Motor %d: value %d", motor_id, value);
+            handle_value(motor_id, value);
+        } else {
+            ESP_LOGW(TAG, "Failed to parse value from: %s", &rx_buffer[6]);
+        }
+    } else if (strncmp(rx_buffer, "ANGLE:", 6) == 0) {
+        int motor_id = 0, angle = 0;
+        if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &angle) == 2 || sscanf(&rx_buffer[6], "%d", &angle) == 1) {
+            if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &angle) != 2) {
+                motor_id = 0;  // Default to motor 0 if not specified
+            }
+            PANEL_HOT_LOGI(TAG, "Motor %d: Parsed angle: %d degrees", motor_id, angle);
+            if (motor_id_valid(motor_id)) {
+                instrument_motor_command(motor_id, angle, instrument_motor_min[motor_id], instrument_motor_max[motor_id]);
+            }
+        } else {
+            ESP_LOGW(TAG, "Failed to parse angle from: %s", &rx_buffer[6]);
+        }
+    } else if (strncmp(rx_buffer, "MOVE:", 5) == 0) {
+        int motor_id = 0, angle = 0, min_angle = 0, max_angle = 360;
+        sscanf(&rx_buffer[5], "%d:%d:%d:%d", &motor_id, &angle, &min_angle, &max_angle);
+        if (motor_id_valid(motor_id) && min_angle == 0 && max_angle == 360) {
+            min_angle = instrument_motor_min[motor_id];
+            max_angle = instrument_motor_max[motor_id];
+        }
+        PANEL_HOT_LOGI(TAG, "Motor %d -> %d degrees (range: %d-%d)", motor_id, angle, min_angle, max_angle);
+        if (motor_id_valid(motor_id)) {
+            instrument_motor_command(motor_id, angle, min_angle, max_angle);
+        }
+    } else if (strncmp(rx_buffer, "BOUNDS:", 7) == 0) {
+        int motor_id = 0, min_angle = 0, max_angle = 360;
+        if (sscanf(&rx_buffer[7], "%d:%d:%d", &motor_id, &min_angle, &max_angle) == 3 && motor_id_valid(motor_id)) {
+            instrument_motor_min[motor_id] = min_angle;
+            instrument_motor_max[motor_id] = max_angle;
+            ESP_LOGI(TAG, "Motor %d bounds set: %d to %d degrees", motor_id, min_angle, max_angle);
+        } else {
+            ESP_LOGW(TAG, "Failed to parse bounds from: %s", &rx_buffer[7]);
+        }
+    } else if (strncmp(rx_buffer, "ZERO:", 5) == 0) {
+        int motor_id = 0;
+        sscanf(&rx_buffer[5], "%d", &motor_id);
+        handle_zero(motor_id);
+    } else if (strncmp(rx_buffer, "CAL:", 4) == 0) {
+        // CAL:<motor>:<v1>,<a1>;<v2>,<a2>;... replaces the motor's
+        // calibration table; validated and persisted in the motor layer
+        char *p = &rx_buffer[4];
+        int motor_id = (int)strtol(p, &p, 10);
+        cal_point_t points[INSTRUMENT_MAX_CAL_POINTS];
+        int count = 0;
+        bool ok = (*p == ':') && motor_id_valid(motor_id);
+        while (ok && *p != '\0') {
+            if (count >= INSTRUMENT_MAX_CAL_POINTS) {
+                ok = false;
+                break;
+            }
+            char *end;
+            points[count].value = (int)strtol(p + 1, &end, 10);
+            if (end == p + 1 || *end != ',') {
+                ok = false;
+                break;
+            }
+            p = end;
+            points[count].angle = (int)strtol(p + 1, &end, 10);
+            if (end == p + 1 || (*end != ';' && *end != '\0')) {
+                ok = false;
+                break;
+            }
+            p = end;
+            count++;
+        }
+        if (!ok || !instrument_motor_set_calibration(motor_id, points, count)) {
+            ESP_LOGW(TAG, "Failed to parse calibration from: %s", rx_buffer);
+            panel_counters.rx_errors++;
+        }
+    } else {
+        // Unknown command: reclassify from text to error
+        panel_counters.rx_text--;
+        panel_counters.rx_errors++;
+    }
+}
+
+// The command path runs as a udp_recv callback in the lwIP thread. The
+// decoder reads the pbuf payload in place, so binary frames and bundles
+// are handled with zero copies and no task wakeup -- only the decoded
+// target crosses to the motor mailbox. The old recvfrom task paid a
+// pbuf-to-buffer copy, a context switch and an 8 KB stack per device.
+// Text commands are linearized into a static bounce buffer (the callback
+// is serialized in the lwIP thread) for NUL-terminated parsing.
+static void udp_command_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                             const ip_addr_t *addr, u16_t port)
+{
+    static char rx_buffer[BUFFER_SIZE];
+
+    panel_counters.rx_packets++;
+    int64_t t_rx = esp_timer_get_time();
+
+    int len = p->tot_len;
+    const char *payload = p->payload;
+    if (len > (int)sizeof(rx_buffer) - 1) {
+        panel_counters.rx_errors++;
+        pbuf_free(p);
+        return;
+    }
+    // Chained pbufs are rare for our sub-100-byte datagrams; linearize so
+    // the decoders see contiguous bytes
+    if (p->next != NULL) {
+        len = pbuf_copy_partial(p, rx_buffer, sizeof(rx_buffer) - 1, 0);
+        payload = rx_buffer;
+    }
+
+    panel_frame_t frame;
+#if CONFIG_XPLANE_DIRECT
+    if (len > 5 && memcmp(payload, "RREF,", 5) == 0) {
+        panel_counters.rx_binary++;
+        handle_rref(payload, len);
+    } else
+#endif
+    if (len >= (int)sizeof(panel_bundle_t) && (uint8_t)payload[0] == PANEL_BUNDLE_MAGIC) {
+        panel_counters.rx_binary++;
+        handle_bundle(payload, len);
+    } else if (panel_frame_decode(payload, len, &frame)) {
+        panel_counters.rx_binary++;
+        handle_binary_frame(&frame);
+    } else {
+        if (payload != rx_buffer) {
+            memcpy(rx_buffer, payload, len);
+        }
+        rx_buffer[len] = 0;
+        dispatch_text(rx_buffer);
+    }
+
+    uint32_t dispatch_us = (uint32_t)(esp_timer_get_time() - t_rx);
+    if (dispatch_us > panel_counters.max_dispatch_us) {
+        panel_counters.max_dispatch_us = dispatch_us;
+    }
+#if CONFIG_PANEL_BENCHMARK
+    bench_record_dispatch(dispatch_us);
+#endif
+
+    pbuf_free(p);
+}
+
+// Runs in the lwIP thread via tcpip_callback: raw-API PCBs must be
+// created and bound under the stack's lock
+static void udp_receiver_start(void *ctx)
+{
+    struct udp_pcb *pcb = udp_new();
+    if (pcb == NULL) {
+        ESP_LOGE(TAG, "Unable to create command PCB");
+        return;
+    }
+
+    err_t err = udp_bind(pcb, IP_ADDR_ANY, UDP_PORT);
+    if (err != ERR_OK) {
+        ESP_LOGE(TAG, "Command PCB bind failed: %d", err);
+        udp_remove(pcb);
+        return;
+    }
+
+    // Join the panel multicast group; unicast commands from the web tools
+    // keep working unchanged
+    ip4_addr_t group;
+    group.addr = ipaddr_addr(PANEL_MCAST_GROUP);
+    if (igmp_joingroup(IP4_ADDR_ANY4, &group) != ERR_OK) {
+        ESP_LOGW(TAG, "Failed to join multicast group %s", PANEL_MCAST_GROUP);
+    } else {
+        ESP_LOGI(TAG, "Joined multicast group %s", PANEL_MCAST_GROUP);
+    }
+
+    udp_recv(pcb, udp_command_recv, NULL);
+    command_pcb = pcb;
+    ESP_LOGI(TAG, "Command receiver on port %d (lwIP callback)", UDP_PORT);
+
+#if CONFIG_XPLANE_DIRECT
+    // Already in the lwIP thread; subscribe immediately rather than
+    // waiting for the first heartbeat-driven refresh
+    xplane_subscribe(NULL);
+    ESP_LOGI(TAG, "Direct X-Plane mode: RREF subscriptions sent to %s at %d Hz",
+             CONFIG_XPLANE_IP_ADDRESS, CONFIG_XPLANE_RREF_RATE);
+#endif
+}
+
+// Ships the hot-path counters to the hub every few seconds. The counters
+// are sampled without locking: a torn read costs one slightly stale field
+// in one report, which is fine for diagnostics.
+static void stats_task(void *pvParameters)
+{
+    struct sockaddr_in dest_addr;
+    dest_addr.sin_addr.s_addr = inet_addr((const char *)RPI_IP);
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(PANEL_STATS_PORT);
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create stats socket");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(5000));
+
+        panel_stats_frame_t stats = {
+            .magic = PANEL_STATS_MAGIC,
+            .version = PANEL_STATS_VERSION,
+            .uptime_s = xTaskGetTickCount() * portTICK_PERIOD_MS / 1000,
+            .rx_packets = panel_counters.rx_packets,
+            .rx_binary = panel_counters.rx_binary,
+            .rx_text = panel_counters.rx_text,
+            .rx_errors = panel_counters.rx_errors,
+            .motor_steps = panel_counters.motor_steps,
+            .isr_overruns = panel_counters.isr_overruns,
+            .log_dropped = panel_counters.log_dropped,
+            .free_heap = esp_get_free_heap_size(),
+            .max_dispatch_us = panel_counters.max_dispatch_us,
+        };
+        strncpy(stats.esp_id, ESP_ID, sizeof(stats.esp_id) - 1);
+
+        panel_counters.max_dispatch_us = 0;  // Per-window maximum
+
+        sendto(sock, &stats, sizeof(stats), 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    }
+}
+
+void net_start_tasks(void)
+{
+    xTaskCreate(heartbeat_task, "heartbeat", 4096, NULL, 5, NULL);
+    xTaskCreate(stats_task, "stats", 2048, NULL, 1, NULL);
+    // Input-only devices have no motors to command; skip the receiver
+    if (instrument_desc->motor_count > 0) {
+        tcpip_callback(udp_receiver_start, NULL);
+    }
+}
@@ -0,0 +1,196 @@
+/* 0.42" SSD1306 OLED status display (72x40 visible window).
+ *
+ * Only some builds have the display fitted; when the instrument descriptor
+ * says has_oled is false, every call here is a no-op so the rest of the
+ * core never has to check.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "driver/i2c_master.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_ssd1306.h"
+#include "instrument_internal.h"
+
+static const char *TAG = "oled";
+
+#define I2C_SDA         5
+#define I2C_SCL         6
+#define I2C_ADDR        0x3C
+#define LCD_W           72
+#define LCD_H           40
+#define LCD_X_GAP       28
+#define LCD_Y_GAP       14
+#define LCD_BUF_SIZE    (LCD_W * LCD_H / 8)
+
+static esp_lcd_panel_handle_t oled_panel = NULL;
+
+static void set_pixel(uint8_t *buf, int x, int y, bool on)
+{
+    if (x < 0 || x >= LCD_W || y < 0 || y >= LCD_H) return;
+    int idx = (y / 8) * LCD_W + x;
+    if (on) buf[idx] |=  (1 << (y % 8));
+    else    buf[idx] &= ~(1 << (y % 8));
+}
+
+static const uint8_t font5x7[][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x14,0x08,0x3E,0x08,0x14}, {0x08,0x08,0x3E,0x08,0x08},
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A},
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+    {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43},
+};
+
+static void draw_char(uint8_t *buf, int x, int y, char c)
+{
+    if (c < 32 || c > 90) c = 32;
+    const uint8_t *g = font5x7[c - 32];
+    for (int col = 0; col < 5; col++)
+        for (int row = 0; row < 7; row++)
+            set_pixel(buf, x + col, y + row, (g[col] >> row) & 1);
+}
+
+static void draw_string(uint8_t *buf, int x, int y, const char *s)
+{
+    while (*s) { draw_char(buf, x, y, *s++); x += 6; }
+}
+
+// Framebuffer plus a shadow copy of what the panel last received. Updates
+// compare the two per 8-pixel page and transfer only the pages that
+// changed, so redrawing one live value costs one or two page writes on the
+// 400 kHz I2C bus instead of a full 360-byte frame.
+static uint8_t fb[LCD_BUF_SIZE];
+static uint8_t fb_shadow[LCD_BUF_SIZE];
+
+void oled_display(const char *l1, const char *l2, const char *l3)
+{
+    if (!oled_panel) return;
+    memset(fb, 0, sizeof(fb));
+    if (l1) draw_string(fb, 1,  1, l1);
+    if (l2) draw_string(fb, 4, 12, l2);
+    if (l3) draw_string(fb, 16, 23, l3);
+
+    for (int page = 0; page < LCD_H / 8; page++) {
+        uint8_t *row = &fb[page * LCD_W];
+        if (memcmp(row, &fb_shadow[page * LCD_W], LCD_W) != 0) {
+            esp_lcd_panel_draw_bitmap(oled_panel, 0, page * 8, LCD_W, (page + 1) * 8, row);
+            memcpy(&fb_shadow[page * LCD_W], row, LCD_W);
+        }
+    }
+}
+
+// Asynchronous status updates: the I2C transfer in oled_display blocks the
+// caller, so hot-path code must never invoke it directly. Callers drop the
+// three lines into a single-slot mailbox instead and a low-priority render
+// task does the draw and transfer; rapid updates overwrite each other so
+// the panel always shows the newest state, same as the motor mailbox.
+typedef struct {
+    char l1[16];
+    char l2[16];
+    char l3[16];
+} oled_status_t;
+
+static QueueHandle_t oled_mailbox = NULL;
+
+void instrument_oled_status(const char *l1, const char *l2, const char *l3)
+{
+    if (!oled_mailbox) return;
+
+    oled_status_t status = {0};
+    if (l1) snprintf(status.l1, sizeof(status.l1), "%s", l1);
+    if (l2) snprintf(status.l2, sizeof(status.l2), "%s", l2);
+    if (l3) snprintf(status.l3, sizeof(status.l3), "%s", l3);
+    xQueueOverwrite(oled_mailbox, &status);
+}
+
+static void oled_render_task(void *pvParameters)
+{
+    oled_status_t status;
+
+    while (1) {
+        if (xQueueReceive(oled_mailbox, &status, portMAX_DELAY) == pdTRUE) {
+            oled_display(status.l1[0] ? status.l1 : NULL,
+                         status.l2[0] ? status.l2 : NULL,
+                         status.l3[0] ? status.l3 : NULL);
+        }
+    }
+}
+
+// Instrument name on line 1, the IP split across lines 2 and 3
+void oled_show_ip(const char *ip)
+{
+    if (!oled_panel) return;
+
+    char addr[32];
+    strncpy(addr, ip, sizeof(addr) - 1);
+    addr[sizeof(addr) - 1] = 0;
+
+    char *dot = strchr(addr, '.');
+    char line2[18] = {0}, line3[18] = {0};
+    if (dot) {
+        int first_part_len = dot - addr;
+        strncpy(line2, addr, first_part_len + 4);
+        snprintf(line3, sizeof(line3), "  %s", dot + 4);
+    }
+    oled_display(instrument_desc->name, line2, line3);
+}
+
+void init_oled(void)
+{
+    if (!instrument_desc->has_oled) return;
+
+    i2c_master_bus_config_t bus_cfg = {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .i2c_port = I2C_NUM_0,
+        .sda_io_num = I2C_SDA,
+        .scl_io_num = I2C_SCL,
+        .glitch_ignore_cnt = 7,
+    };
+    i2c_master_bus_handle_t bus;
+    ESP_ERROR_CHECK(i2c_new_master_bus(&bus_cfg, &bus));
+
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_panel_io_i2c_config_t io_cfg = {
+        .dev_addr = I2C_ADDR,
+        .scl_speed_hz = 400000,
+        .control_phase_bytes = 1,
+        .dc_bit_offset = 6,
+        .lcd_cmd_bits = 8,
+        .lcd_param_bits = 8,
+    };
+    ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c(bus, &io_cfg, &io));
+
+    esp_lcd_panel_dev_config_t panel_cfg = {
+        .bits_per_pixel = 1,
+        .reset_gpio_num = -1,
+    };
+    ESP_ERROR_CHECK(esp_lcd_new_panel_ssd1306(io, &panel_cfg, &oled_panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_reset(oled_panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_init(oled_panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(oled_panel, true));
+
+    static uint8_t blank[128 * 64 / 8];
+    memset(blank, 0, sizeof(blank));
+    esp_lcd_panel_set_gap(oled_panel, 0, 0);
+    esp_lcd_panel_draw_bitmap(oled_panel, 0, 0, 128, 64, blank);
+    esp_lcd_panel_set_gap(oled_panel, LCD_X_GAP, LCD_Y_GAP);
+
+    oled_mailbox = xQueueCreate(1, sizeof(oled_status_t));
+    xTaskCreate(oled_render_task, "oled_render", 2048, NULL, 1, NULL);
+
+    ESP_LOGI(TAG, "OLED initialized");
+}
@@ -1,79 +1,27 @@
-/* Turn Coordinator Example
-
-   This example code is in the Public Domain (or CC0 licensed, at your option.)
-
-   Unless required by applicable law or agreed to in writing, this
-   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
-   CONDITIONS OF ANY KIND, either express or implied.
-*/
-#include <stdio.h>
-#include <string.h>
-#include <errno.h>
-#include <stdint.h>
-#include <stddef.h>
-#include "rom/ets_sys.h"
+/* Turn coordinator: motor 0 is the aircraft symbol (turn rate), motor 1 the
+ * slip/skid ball.
+ *
+ * Values outside the ±20 deg/sec calibration range are ignored rather than
+ * clamped -- X-Plane sends large transients during scenery loads and the
+ * needle should not slam to its stop when that happens.
+ */
+#include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
-#include "esp_task_wdt.h"
-#include "esp_log.h"
-#include "esp_wifi.h"
-#include "esp_event.h"
-#include "nvs_flash.h"
-#include "lwip/sockets.h"
-#include "lwip/netif.h"
-#include "driver/gpio.h"
-#include "driver/gptimer.h"
-#include "config.h"
-#include "esp_http_client.h"
+#include "instrument_core.h"
 
-static const char *TAG = "turn_indicator";
-#define UDP_PORT       49003
-#define HEARTBEAT_PORT 49002
-#define BUFFER_SIZE    1024
-#define HEARTBEAT_INTERVAL 5000
-#define LOG_PORT       9999
-#define LOG_BUFFER_SIZE 1024
+static const char *TAG = "turn";
 
-// Motor 0 (main turn rate needle)
 #define MOTOR_IN1 3
 #define MOTOR_IN2 4
 #define MOTOR_IN3 5
 #define MOTOR_IN4 6
 
-// Motor 1 (slip/skid ball) - with enforced bounds
 #define MOTOR2_IN1 7
 #define MOTOR2_IN2 8
 #define MOTOR2_IN3 9
 #define MOTOR2_IN4 10
 
-#define MOTOR_STEP_PERIOD_US 5000
-#define RESOLUTION_MODE 0
-
-static float current_position[2] = {0, 0};
-static int seq_idx[2] = {0, 0};
-
-typedef struct {
-    int target_angle;
-    int steps_remaining;
-    int direction;
-    bool active;
-} motor_state_t;
-
-static motor_state_t motor_state[2] = {{0}, {0}};
-
-static const uint8_t SEQUENCE_FULL[4][4] = {
-    {1, 1, 0, 0},
-    {0, 1, 1, 0},
-    {0, 0, 1, 1},
-    {1, 0, 0, 1},
-};
-
-typedef struct {
-    int value;
-    int angle;
-} cal_point_t;
-
 // Motor 0 - Turn Coordinator: -20 to +20 degrees per second turn rate
 // Maps turn rate directly to needle angle
 // 0 deg/sec = 0°, +20 deg/sec = 20°, -20 deg/sec = -20°
@@ -84,11 +32,9 @@ static const cal_point_t calibration_motor0[5] = {
     {10,     10},
     {20,     20},
 };
-static const int calibration_motor0_count = 5;
 
 // Motor 1 - Slip/Skid Ball: -20 to +20 degrees per second turn rate
-// Maps turn rate to ±15 degrees of slip/skid compensation
-// 0 deg/sec = 0°, +20 deg/sec = 15°, -20 deg/sec = -15°
+// Maps turn rate to ±18 degrees of slip/skid compensation
 static const cal_point_t calibration_motor1[5] = {
     {-20,    -18},
     {-10,    -9},
@@ -96,474 +42,66 @@ static const cal_point_t calibration_motor1[5] = {
     {10,     9},
     {20,     18},
 };
-static const int calibration_motor1_count = 5;
-
-// Motor bounds derived from calibration min/max values
-static int motor0_min_angle;
-static int motor0_max_angle;
-static int motor1_min_angle;
-static int motor1_max_angle;
-
-static int value_to_angle(int motor_id, int value)
-{
-    const cal_point_t *calibration;
-    int calibration_count;
-    int min_value, max_value;
-    
-    if (motor_id == 0) {
-        calibration = calibration_motor0;
-        calibration_count = calibration_motor0_count;
-        min_value = calibration_motor0[0].value;
-        max_value = calibration_motor0[calibration_motor0_count - 1].value;
-    } else if (motor_id == 1) {
-        calibration = calibration_motor1;
-        calibration_count = calibration_motor1_count;
-        min_value = calibration_motor1[0].value;
-        max_value = calibration_motor1[calibration_motor1_count - 1].value;
-    } else {
-        return 0;
-    }
-    
-    if (value < min_value || value > max_value) {
-        ESP_LOGW(TAG, "Motor %d: Value %d outside calibration bounds [%d, %d], ignoring", motor_id, value, min_value, max_value);
-        return -1;
-    }
-    
-    if (value <= calibration[0].value) return calibration[0].angle;
-    if (value >= calibration[calibration_count - 1].value) return calibration[calibration_count - 1].angle;
-    
-    for (int i = 0; i < calibration_count - 1; i++) {
-        if (value >= calibration[i].value && value <= calibration[i + 1].value) {
-            int v1 = calibration[i].value;
-            int v2 = calibration[i + 1].value;
-            int a1 = calibration[i].angle;
-            int a2 = calibration[i + 1].angle;
-            
-            if (v1 == v2) return a1;
-            
-            float ratio = (float)(value - v1) / (v2 - v1);
-            int angle_diff = a2 - a1;
-            if (angle_diff > 180) angle_diff -= 360;
-            else if (angle_diff < -180) angle_diff += 360;
-            
-            int angle = (int)(a1 + ratio * angle_diff);
-            return angle;
-        }
-    }
-    
-    return calibration[calibration_count - 1].angle;
-}
-
-static bool motor_timer_callback(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *user_ctx)
-{
-    int motor_id = (intptr_t)user_ctx;
-    
-    if (!motor_state[motor_id].active || motor_state[motor_id].steps_remaining <= 0) {
-        return false;
-    }
-    
-    int seq_len = 4;
-    const uint8_t (*sequence)[4] = SEQUENCE_FULL;
-    
-    // Set GPIO based on motor
-    if (motor_id == 0) {
-        gpio_set_level(MOTOR_IN1, sequence[seq_idx[motor_id]][0]);
-        gpio_set_level(MOTOR_IN2, sequence[seq_idx[motor_id]][1]);
-        gpio_set_level(MOTOR_IN3, sequence[seq_idx[motor_id]][2]);
-        gpio_set_level(MOTOR_IN4, sequence[seq_idx[motor_id]][3]);
-    } else {
-        gpio_set_level(MOTOR2_IN1, sequence[seq_idx[motor_id]][0]);
-        gpio_set_level(MOTOR2_IN2, sequence[seq_idx[motor_id]][1]);
-        gpio_set_level(MOTOR2_IN3, sequence[seq_idx[motor_id]][2]);
-        gpio_set_level(MOTOR2_IN4, sequence[seq_idx[motor_id]][3]);
-    }
-    
-    if (motor_state[motor_id].direction > 0) {
-        seq_idx[motor_id] = (seq_idx[motor_id] + 1) % seq_len;
-    } else {
-        seq_idx[motor_id] = (seq_idx[motor_id] - 1 + seq_len) % seq_len;
-    }
-    
-    motor_state[motor_id].steps_remaining--;
-    
-    if (motor_state[motor_id].steps_remaining <= 0) {
-        motor_state[motor_id].active = false;
-        current_position[motor_id] = motor_state[motor_id].target_angle;
-        ESP_LOGI(TAG, "Motor %d reached target: %d°", motor_id, motor_state[motor_id].target_angle);
-        return false;
-    }
-    
-    return true;
-}
-
-static gptimer_handle_t motor_timer[2] = {NULL, NULL};
 
-static void calibration_init(void)
+// Ignore values outside the calibration range instead of clamping to it
+static bool turn_on_value(int motor_id, int value)
 {
-    // Derive bounds from calibration arrays
-    motor0_min_angle = calibration_motor0[0].angle;
-    motor0_max_angle = calibration_motor0[calibration_motor0_count - 1].angle;
-    motor1_min_angle = calibration_motor1[0].angle;
-    motor1_max_angle = calibration_motor1[calibration_motor1_count - 1].angle;
-    
-    ESP_LOGI(TAG, "Motor 0 bounds: [%d, %d]°", motor0_min_angle, motor0_max_angle);
-    ESP_LOGI(TAG, "Motor 1 bounds: [%d, %d]°", motor1_min_angle, motor1_max_angle);
-}
+    const cal_point_t *calibration = (motor_id == 0) ? calibration_motor0 : calibration_motor1;
 
-static void motor_init(void)
-{
-    // Motor 0
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << MOTOR_IN1) | (1ULL << MOTOR_IN2) | (1ULL << MOTOR_IN3) | (1ULL << MOTOR_IN4),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&io_conf);
-    gpio_set_level(MOTOR_IN1, 0);
-    gpio_set_level(MOTOR_IN2, 0);
-    gpio_set_level(MOTOR_IN3, 0);
-    gpio_set_level(MOTOR_IN4, 0);
-    
-    // Motor 1
-    io_conf.pin_bit_mask = (1ULL << MOTOR2_IN1) | (1ULL << MOTOR2_IN2) | (1ULL << MOTOR2_IN3) | (1ULL << MOTOR2_IN4);
-    gpio_config(&io_conf);
-    gpio_set_level(MOTOR2_IN1, 0);
-    gpio_set_level(MOTOR2_IN2, 0);
-    gpio_set_level(MOTOR2_IN3, 0);
-    gpio_set_level(MOTOR2_IN4, 0);
-    
-    // Initialize timers for both motors
-    for (int m = 0; m < 2; m++) {
-        gptimer_config_t timer_config = {
-            .clk_src = GPTIMER_CLK_SRC_DEFAULT,
-            .direction = GPTIMER_COUNT_UP,
-            .resolution_hz = 1000000,
-        };
-        
-        ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &motor_timer[m]));
-        gptimer_alarm_config_t alarm_config = {
-            .alarm_count = MOTOR_STEP_PERIOD_US,
-            .reload_count = 0,
-            .flags.auto_reload_on_alarm = true,
-        };
-        ESP_ERROR_CHECK(gptimer_set_alarm_action(motor_timer[m], &alarm_config));
-        
-        gptimer_event_callbacks_t cbs = {
-            .on_alarm = motor_timer_callback,
-        };
-        ESP_ERROR_CHECK(gptimer_register_event_callbacks(motor_timer[m], &cbs, (void *)(intptr_t)m));
-        ESP_ERROR_CHECK(gptimer_enable(motor_timer[m]));
+    if (value < calibration[0].value || value > calibration[4].value) {
+        PANEL_HOT_LOGW(TAG, "Motor %d: Value %d outside calibration bounds [%d, %d], ignoring",
+                 motor_id, value, calibration[0].value, calibration[4].value);
+        return true;  // Consumed: no motion
     }
-    
-    calibration_init();
-    ESP_LOGI(TAG, "Motor timers initialized");
+    return false;  // In range: fall back to the shared lookup
 }
 
-static void motor_move_to(int motor_id, int target_angle, int min_angle, int max_angle)
-{
-    // Clamp target to valid range
-    if (target_angle < min_angle) target_angle = min_angle;
-    if (target_angle > max_angle) target_angle = max_angle;
-    
-    int current = (int)current_position[motor_id];
-    int diff = target_angle - current;
-    
-    // Both motors are linear instruments: use direct shortest path
-    // No wrapping around 360° needed
-    
-    if (diff == 0) {
-        ESP_LOGI(TAG, "Motor %d already at target: %d°", motor_id, target_angle);
-        return;
-    }
-    
-    int steps = (abs(diff) * 2048 + 180) / 360;  // Round to nearest step
-    int direction = (diff >= 0) ? 1 : -1;
-    
-    ESP_LOGI(TAG, "Motor %d START: current=%d°, target=%d° (diff: %d°, steps: %d, dir: %s)", 
-             motor_id, current, target_angle, diff, steps, (direction > 0) ? "CW" : "CCW");
-    
-    if (motor_state[motor_id].active) {
-        ESP_ERROR_CHECK(gptimer_stop(motor_timer[motor_id]));
-        motor_state[motor_id].active = false;
-    }
-    
-    motor_state[motor_id].target_angle = target_angle;
-    motor_state[motor_id].steps_remaining = steps;
-    motor_state[motor_id].direction = direction;
-    motor_state[motor_id].active = true;
-    
-    ESP_ERROR_CHECK(gptimer_set_raw_count(motor_timer[motor_id], 0));
-    ESP_ERROR_CHECK(gptimer_start(motor_timer[motor_id]));
-}
-
-static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
-{
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
-    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        ESP_LOGI(TAG, "Disconnected, reconnecting...");
-        esp_wifi_connect();
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
-    }
-}
-
-static void wifi_init(void)
-{
-    ESP_ERROR_CHECK(nvs_flash_init());
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
-
-    wifi_config_t wifi_config = {0};
-    strncpy((char *)wifi_config.sta.ssid, WIFI_SSID, sizeof(wifi_config.sta.ssid) - 1);
-    strncpy((char *)wifi_config.sta.password, WIFI_PASS, sizeof(wifi_config.sta.password) - 1);
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
-}
-
-static int log_socket = -1;
-
-static int wifi_log_vprintf(const char *fmt, va_list args)
-{
-    static char log_buffer[LOG_BUFFER_SIZE];
-    int len = vsnprintf(log_buffer, LOG_BUFFER_SIZE - 1, fmt, args);
-    
-    if (log_socket >= 0 && len > 0) {
-        send(log_socket, (uint8_t *)log_buffer, len, 0);
-    }
-    return len;
-}
-
-static void wifi_logging_task(void *pvParameters)
-{
-    struct sockaddr_in server_addr;
-    int server_socket;
-    
-    server_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (server_socket < 0) {
-        ESP_LOGE(TAG, "Failed to create log server socket");
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    int opt = 1;
-    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    server_addr.sin_port = htons(LOG_PORT);
-    
-    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        ESP_LOGE(TAG, "Failed to bind log server socket");
-        close(server_socket);
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    listen(server_socket, 1);
-    ESP_LOGI(TAG, "WiFi logging server listening on port %d", LOG_PORT);
-    
-    while (1) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        int client_socket = accept(server_socket, (struct sockaddr *)&client_addr, &client_len);
-        if (client_socket >= 0) {
-            log_socket = client_socket;
-            ESP_LOGI(TAG, "WiFi logging client connected: %s", inet_ntoa(client_addr.sin_addr));
-            
-            char dummy[256];
-            while (recv(client_socket, dummy, sizeof(dummy), 0) > 0) {
-                vTaskDelay(pdMS_TO_TICKS(100));
-            }
-            
-            ESP_LOGI(TAG, "WiFi logging client disconnected");
-            close(client_socket);
-            log_socket = -1;
-        }
-    }
-}
-
-static void heartbeat_task(void *pvParameters)
-{
-    esp_task_wdt_add(NULL);
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
-    
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_addr.s_addr = inet_addr((const char *)RPI_IP);
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(HEARTBEAT_PORT);
-
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-    if (sock < 0) {
-        ESP_LOGE(TAG, "Unable to create heartbeat socket");
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    ESP_LOGI(TAG, "Heartbeat task started, sending to %s:%d", RPI_IP, HEARTBEAT_PORT);
-
-    char heartbeat_msg[64];
-    int heartbeat_count = 0;
-
-    while (1) {
-        esp_task_wdt_reset();
-        uint32_t uptime = xTaskGetTickCount() * portTICK_PERIOD_MS / 1000;
-        snprintf(heartbeat_msg, sizeof(heartbeat_msg), "HEARTBEAT:%s:%lu", ESP_ID, (unsigned long)uptime);
-        
-        int ret = sendto(sock, heartbeat_msg, strlen(heartbeat_msg), 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-        if (ret < 0) {
-            ESP_LOGW(TAG, "Heartbeat send failed: errno %d, to %s:%d", errno, RPI_IP, HEARTBEAT_PORT);
-        } else {
-            heartbeat_count++;
-            if (heartbeat_count % 6 == 0) {
-                ESP_LOGI(TAG, "Heartbeat sent (%d sent, msg: %s)", heartbeat_count, heartbeat_msg);
-            }
-        }
-        
-        esp_task_wdt_reset();
-        vTaskDelay(HEARTBEAT_INTERVAL / portTICK_PERIOD_MS);
-    }
-}
-
-static void udp_receiver_task(void *pvParameters)
-{
-    char rx_buffer[BUFFER_SIZE];
-    struct sockaddr_in dest_addr;
-    
-    dest_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(UDP_PORT);
-
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-    if (sock < 0) {
-        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
-        vTaskDelete(NULL);
-        return;
-    }
-
-    int err = bind(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err < 0) {
-        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
-        close(sock);
-        vTaskDelete(NULL);
-        return;
-    }
-    ESP_LOGI(TAG, "Socket bound, listening on port %d", UDP_PORT);
-
-    while (1) {
-        struct sockaddr_in source_addr;
-        socklen_t socklen = sizeof(source_addr);
-        int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer) - 1, 0, (struct sockaddr *)&source_addr, &socklen);
-        
-        if (len < 0) {
-            ESP_LOGW(TAG, "recvfrom failed: errno %d", errno);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            continue;
-        }
-        
-        rx_buffer[len] = 0;
-        ESP_LOGI(TAG, "Received: %s", rx_buffer);
-        
-        if (strncmp(rx_buffer, "VALUE:", 6) == 0) {
-            int motor_id = 0, value = 0;
-            if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &value) == 2 || sscanf(&rx_buffer[6], "%d", &value) == 1) {
-                if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &value) != 2) {
-                    motor_id = 0;
-                }
-                int angle = value_to_angle(motor_id, value);
-                if (angle != -1) {
-                    int max_angle = (motor_id == 0) ? motor0_max_angle : motor1_max_angle;
-                    int min_angle = (motor_id == 0) ? motor0_min_angle : motor1_min_angle;
-                    ESP_LOGI(TAG, "Motor %d: Converted value %d to angle %d degrees", motor_id, value, angle);
-                    motor_move_to(motor_id, angle, min_angle, max_angle);
-                }
-            } else {
-                ESP_LOGW(TAG, "Failed to parse value from: %s", &rx_buffer[6]);
-            }
-        } else if (strncmp(rx_buffer, "ANGLE:", 6) == 0) {
-            int motor_id = 0, angle = 0;
-            if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &angle) == 2 || sscanf(&rx_buffer[6], "%d", &angle) == 1) {
-                if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &angle) != 2) {
-                    motor_id = 0;
-                }
-                int max_angle = (motor_id == 0) ? motor0_max_angle : motor1_max_angle;
-                int min_angle = (motor_id == 0) ? motor0_min_angle : motor1_min_angle;
-                ESP_LOGI(TAG, "Motor %d: Parsed angle: %d degrees", motor_id, angle);
-                motor_move_to(motor_id, angle, min_angle, max_angle);
-            } else {
-                ESP_LOGW(TAG, "Failed to parse angle from: %s", &rx_buffer[6]);
-            }
-        } else if (strncmp(rx_buffer, "MOVE:", 5) == 0) {
-            int motor_id = 0, angle = 0, min_angle = 0, max_angle = 360;
-            sscanf(&rx_buffer[5], "%d:%d:%d:%d", &motor_id, &angle, &min_angle, &max_angle);
-            // Motor 0 uses full range, motor 1 uses stored bounds if not explicitly provided
-            if (motor_id == 1 && min_angle == 0 && max_angle == 360) {
-                min_angle = motor1_min_angle;
-                max_angle = motor1_max_angle;
-            }
-            ESP_LOGI(TAG, "Motor %d -> %d degrees (range: %d-%d)", motor_id, angle, min_angle, max_angle);
-            motor_move_to(motor_id, angle, min_angle, max_angle);
-        } else if (strncmp(rx_buffer, "ZERO:", 5) == 0) {
-            int motor_id = 0;
-            sscanf(&rx_buffer[5], "%d", &motor_id);
-            int zero_angle = 0;  // All motors zero to 0° (center)
-            current_position[motor_id] = zero_angle;
-            seq_idx[motor_id] = 0;
-            ESP_LOGI(TAG, "Motor %d zeroed to %d degrees", motor_id, zero_angle);
-        } else if (strncmp(rx_buffer, "BOUNDS:", 7) == 0) {
-            // Set motor 1 bounds: BOUNDS:min:max
-            int min_angle = 0, max_angle = 360;
-            sscanf(&rx_buffer[7], "%d:%d", &min_angle, &max_angle);
-            motor1_min_angle = min_angle;
-            motor1_max_angle = max_angle;
-            ESP_LOGI(TAG, "Motor 1 bounds set to %d-%d degrees", min_angle, max_angle);
-        }
-    }
-
-    close(sock);
-    vTaskDelete(NULL);
-}
+static const instrument_desc_t turn_desc = {
+    .name = "TURN",
+    .motor_count = 2,
+    .motors = {
+        {
+            .pin_in1 = MOTOR_IN1,
+            .pin_in2 = MOTOR_IN2,
+            .pin_in3 = MOTOR_IN3,
+            .pin_in4 = MOTOR_IN4,
+            .calibration = calibration_motor0,
+            .calibration_count = 5,
+            // Bounds match the calibration endpoints
+            .min_angle = -20,
+            .max_angle = 20,
+            .zero_angle = 0,
+            .path_mode = MOTOR_PATH_CLAMP,
+            // Light needles over a +/-20 degree arc: cruise at the stall
+            // floor, half the period of the heavier full-circle dials
+            .ramp_start_period_us = 5000,
+            .ramp_min_period_us = 700,
+            .ramp_step_us = 100,
+        },
+        {
+            .pin_in1 = MOTOR2_IN1,
+            .pin_in2 = MOTOR2_IN2,
+            .pin_in3 = MOTOR2_IN3,
+            .pin_in4 = MOTOR2_IN4,
+            .calibration = calibration_motor1,
+            .calibration_count = 5,
+            .min_angle = -18,
+            .max_angle = 18,
+            .zero_angle = 0,
+            .path_mode = MOTOR_PATH_CLAMP,
+            .ramp_start_period_us = 5000,
+            .ramp_min_period_us = 700,
+            .ramp_step_us = 100,
+        },
+    },
+    .on_value = turn_on_value,
+};
 
 void app_main(void)
 {
-    ESP_LOGI(TAG, "Starting Turn Indicator on port %d", UDP_PORT);
-    
-    esp_task_wdt_config_t wdt_config = {
-        .timeout_ms = 60000,
-        .idle_core_mask = (1 << portNUM_PROCESSORS) - 1,
-        .trigger_panic = true,
-    };
-    esp_task_wdt_init(&wdt_config);
-    
-    motor_init();
-    wifi_init();
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
-    
-    xTaskCreate(wifi_logging_task, "wifi_log", 4096, NULL, 2, NULL);
-    vTaskDelay(500 / portTICK_PERIOD_MS);
-    esp_log_set_vprintf(wifi_log_vprintf);
-    
-    xTaskCreate(heartbeat_task, "heartbeat", 4096, NULL, 5, NULL);
-    xTaskCreate(udp_receiver_task, "udp_receiver", 8192, NULL, 3, NULL);
-    
-    // CRITICAL: Don't move motors on startup - just set internal positions to starting points
-    current_position[0] = 0;    // Motor 0: starts at 0 degrees (turn rate needle)
-    current_position[1] = 0;    // Motor 1: starts at 0 degrees (slip/skid ball)
-    seq_idx[0] = 0;
-    seq_idx[1] = 0;
-    ESP_LOGI(TAG, "Initialization complete. Motors NOT moved. Ready for commands.");
-    
+    instrument_core_start(&turn_desc);
+
+    // Main task just sleeps, no need to monitor it
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(10000));
     }
@@ -1,65 +1,20 @@
-#include <stdio.h>
-#include <string.h>
-#include <errno.h>
-#include <stdint.h>
-#include <stddef.h>
-#include "rom/ets_sys.h"
+/* Vertical speed indicator: -2000 to +2000 fpm, 0 fpm at 270°.
+ *
+ * The needle sweeps almost the whole dial but must never cross the gap
+ * between 82° (+2000 fpm) and 98° (-2000 fpm); MOTOR_PATH_WRAP_AVOID with
+ * avoid_angle 90 makes the engine route every move around it.
+ */
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
-#include "esp_task_wdt.h"
-#include "esp_log.h"
-#include "esp_wifi.h"
-#include "esp_event.h"
-#include "nvs_flash.h"
-#include "lwip/sockets.h"
-#include "lwip/netif.h"
-#include "driver/gpio.h"
-#include "driver/gptimer.h"
-#include "config.h"
-#include "esp_http_client.h"
-
-static const char *TAG = "udp_receiver";
-#define UDP_PORT       49003
-#define HEARTBEAT_PORT 49002
-#define BUFFER_SIZE    1024
-#define HEARTBEAT_INTERVAL 5000
-#define LOG_PORT       9999
-#define LOG_BUFFER_SIZE 1024
+#include "instrument_core.h"
 
 #define MOTOR_IN1 3
 #define MOTOR_IN2 4
 #define MOTOR_IN3 5
 #define MOTOR_IN4 6
-#define MOTOR_STEP_PERIOD_US 5000
-#define RESOLUTION_MODE 0
-
-static int current_position = 0;  // Track actual motor position in degrees
-static int total_steps_from_zero = 0;  // Total steps taken from 0°
-
-typedef struct {
-    int target_angle;
-    int steps_remaining;
-    int direction;
-    bool active;
-} motor_state_t;
-
-static motor_state_t motor_state = {0};
-
-static const uint8_t SEQUENCE_FULL[4][4] = {
-    {1, 1, 0, 0},
-    {0, 1, 1, 0},
-    {0, 0, 1, 1},
-    {1, 0, 0, 1},
-};
-
-typedef struct {
-    int value;
-    int angle;
-} cal_point_t;
 
 // VSI: -2000 to +2000 fpm, linear 0° to 360° (no wrapping)
-static const cal_point_t calibration[] = {
+static const cal_point_t calibration[9] = {
     {-2000, 98},
     {-1500, 143},
     {-1000, 185},
@@ -71,396 +26,36 @@ static const cal_point_t calibration[] = {
     { 2000, 82},
 };
 
-static const int calibration_count = 9;
-
-static int value_to_angle(int value)
-{
-    if (value <= -2000) return 98;
-    if (value >= 2000) return 82;
-    
-    for (int i = 0; i < calibration_count - 1; i++) {
-        if (value >= calibration[i].value && value <= calibration[i + 1].value) {
-            int v1 = calibration[i].value;
-            int v2 = calibration[i + 1].value;
-            int a1 = calibration[i].angle;
-            int a2 = calibration[i + 1].angle;
-            
-            float ratio = (float)(value - v1) / (v2 - v1);
-            int angle = (int)(a1 + ratio * (a2 - a1));
-            
-            return angle;
-        }
-    }
-    
-    return 270;
-}
-
-static bool motor_timer_callback(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *user_ctx)
-{
-    if (!motor_state.active || motor_state.steps_remaining <= 0) {
-        return false;
-    }
-    
-    // Perform one step
-    const uint8_t (*sequence)[4] = SEQUENCE_FULL;
-    
-    int seq_idx = total_steps_from_zero % 4;
-    if (seq_idx < 0) seq_idx += 4;
-    
-    gpio_set_level(MOTOR_IN1, sequence[seq_idx][0]);
-    gpio_set_level(MOTOR_IN2, sequence[seq_idx][1]);
-    gpio_set_level(MOTOR_IN3, sequence[seq_idx][2]);
-    gpio_set_level(MOTOR_IN4, sequence[seq_idx][3]);
-    
-    motor_state.steps_remaining--;
-    total_steps_from_zero += motor_state.direction;
-    
-    if (motor_state.steps_remaining <= 0) {
-        motor_state.active = false;
-        current_position = motor_state.target_angle;
-        ESP_LOGI(TAG, "Motor reached target: %d°", motor_state.target_angle);
-        return false;
-    }
-    
-    return true;
-}
-
-static gptimer_handle_t motor_timer = NULL;
-
-static void motor_init(void)
-{
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << MOTOR_IN1) | (1ULL << MOTOR_IN2) | (1ULL << MOTOR_IN3) | (1ULL << MOTOR_IN4),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&io_conf);
-    gpio_set_level(MOTOR_IN1, 0);
-    gpio_set_level(MOTOR_IN2, 0);
-    gpio_set_level(MOTOR_IN3, 0);
-    gpio_set_level(MOTOR_IN4, 0);
-    
-    gptimer_config_t timer_config = {
-        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
-        .direction = GPTIMER_COUNT_UP,
-        .resolution_hz = 1000000,
-    };
-    
-    ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &motor_timer));
-    gptimer_alarm_config_t alarm_config = {
-        .alarm_count = MOTOR_STEP_PERIOD_US,
-        .reload_count = 0,
-        .flags.auto_reload_on_alarm = true,
-    };
-    ESP_ERROR_CHECK(gptimer_set_alarm_action(motor_timer, &alarm_config));
-    
-    gptimer_event_callbacks_t cbs = {
-        .on_alarm = motor_timer_callback,
-    };
-    ESP_ERROR_CHECK(gptimer_register_event_callbacks(motor_timer, &cbs, NULL));
-    ESP_ERROR_CHECK(gptimer_enable(motor_timer));
-    
-    ESP_LOGI(TAG, "Motor timer initialized with %d µs step period", MOTOR_STEP_PERIOD_US);
-}
-
-static void motor_move_to(int target_angle, int min_angle, int max_angle)
-{
-    if (target_angle < min_angle) target_angle = min_angle;
-    if (target_angle > max_angle) target_angle = max_angle;
-    
-    // Normalize current position to 0-360
-    int current_norm = current_position % 360;
-    if (current_norm < 0) current_norm += 360;
-    
-    // Calculate shortest path on the dial, wrapping around 270 (0 fpm)
-    // The needle operates between 98° (-2000 fpm) and 82° (+2000 fpm)
-    // It should NEVER cross the gap between 82° and 98°
-    int diff = target_angle - current_norm;
-    // If the direct path would cross the 82-98 gap, go the other way
-    if (diff > 0 && current_norm < 90 && target_angle > 90) {
-        // Would cross gap going forward, go backward instead
-        diff -= 360;
-    } else if (diff < 0 && current_norm > 90 && target_angle < 90) {
-        // Would cross gap going backward, go forward instead
-        diff += 360;
-    }
-    
-    // Calculate target steps from zero (absolute position)
-    int target_steps = total_steps_from_zero + (diff * 2048) / 360;
-    int diff_steps = target_steps - total_steps_from_zero;
-    
-    if (diff_steps == 0) {
-        ESP_LOGI(TAG, "Motor already at target: %d°", target_angle);
-        return;
-    }
-    
-    int direction = (diff_steps >= 0) ? 1 : -1;
-    int steps = abs(diff_steps);
-    
-    ESP_LOGI(TAG, "Motor START: current=%d° (%d steps), target=%d° (%d steps), diff=%d steps, dir=%s", 
-             current_position, total_steps_from_zero, target_angle, target_steps, diff_steps, (direction > 0) ? "CW" : "CCW");
-    
-    if (motor_state.active) {
-        ESP_ERROR_CHECK(gptimer_stop(motor_timer));
-        motor_state.active = false;
-    }
-    
-    motor_state.target_angle = target_angle;
-    motor_state.steps_remaining = steps;
-    motor_state.direction = direction;
-    motor_state.active = true;
-    
-    ESP_ERROR_CHECK(gptimer_set_raw_count(motor_timer, 0));
-    ESP_ERROR_CHECK(gptimer_start(motor_timer));
-}
-
-static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
-{
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
-    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        ESP_LOGI(TAG, "Disconnected, reconnecting...");
-        esp_wifi_connect();
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
-    }
-}
-
-static void wifi_init(void)
-{
-    ESP_ERROR_CHECK(nvs_flash_init());
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
-
-    wifi_config_t wifi_config = {0};
-    strncpy((char *)wifi_config.sta.ssid, WIFI_SSID, sizeof(wifi_config.sta.ssid) - 1);
-    strncpy((char *)wifi_config.sta.password, WIFI_PASS, sizeof(wifi_config.sta.password) - 1);
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
-}
-
-static int log_socket = -1;
-
-static int wifi_log_vprintf(const char *fmt, va_list args)
-{
-    static char log_buffer[LOG_BUFFER_SIZE];
-    int len = vsnprintf(log_buffer, LOG_BUFFER_SIZE - 1, fmt, args);
-    
-    if (log_socket >= 0 && len > 0) {
-        send(log_socket, (uint8_t *)log_buffer, len, 0);
-    }
-    return len;
-}
-
-static void wifi_logging_task(void *pvParameters)
-{
-    struct sockaddr_in server_addr;
-    int server_socket;
-    
-    server_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (server_socket < 0) {
-        ESP_LOGE(TAG, "Failed to create log server socket");
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    int opt = 1;
-    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    server_addr.sin_port = htons(LOG_PORT);
-    
-    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        ESP_LOGE(TAG, "Failed to bind log server socket");
-        close(server_socket);
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    listen(server_socket, 1);
-    ESP_LOGI(TAG, "WiFi logging server listening on port %d", LOG_PORT);
-    
-    while (1) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        int client_socket = accept(server_socket, (struct sockaddr *)&client_addr, &client_len);
-        if (client_socket >= 0) {
-            log_socket = client_socket;
-            ESP_LOGI(TAG, "WiFi logging client connected: %s", inet_ntoa(client_addr.sin_addr));
-            
-            char dummy[256];
-            while (recv(client_socket, dummy, sizeof(dummy), 0) > 0) {
-                vTaskDelay(pdMS_TO_TICKS(100));
-            }
-            
-            ESP_LOGI(TAG, "WiFi logging client disconnected");
-            close(client_socket);
-            log_socket = -1;
-        }
-    }
-}
-
-static void heartbeat_task(void *pvParameters)
-{
-    esp_task_wdt_add(NULL);
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
-    
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_addr.s_addr = inet_addr((const char *)RPI_IP);
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(HEARTBEAT_PORT);
-
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-    if (sock < 0) {
-        ESP_LOGE(TAG, "Unable to create heartbeat socket");
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    ESP_LOGI(TAG, "Heartbeat task started, sending to %s:%d", RPI_IP, HEARTBEAT_PORT);
-
-    char heartbeat_msg[64];
-    int heartbeat_count = 0;
-
-    while (1) {
-        esp_task_wdt_reset();
-        uint32_t uptime = xTaskGetTickCount() * portTICK_PERIOD_MS / 1000;
-        snprintf(heartbeat_msg, sizeof(heartbeat_msg), "HEARTBEAT:%s:%lu", ESP_ID, (unsigned long)uptime);
-        
-        int ret = sendto(sock, heartbeat_msg, strlen(heartbeat_msg), 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-        if (ret < 0) {
-            ESP_LOGW(TAG, "Heartbeat send failed: errno %d, to %s:%d", errno, RPI_IP, HEARTBEAT_PORT);
-        } else {
-            heartbeat_count++;
-            if (heartbeat_count % 6 == 0) {
-                ESP_LOGI(TAG, "Heartbeat sent (%d sent, msg: %s)", heartbeat_count, heartbeat_msg);
-            }
-        }
-        
-        esp_task_wdt_reset();
-        vTaskDelay(HEARTBEAT_INTERVAL / portTICK_PERIOD_MS);
-    }
-}
-
-static void udp_receiver_task(void *pvParameters)
-{
-    char rx_buffer[BUFFER_SIZE];
-    struct sockaddr_in dest_addr;
-    
-    dest_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(UDP_PORT);
-
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-    if (sock < 0) {
-        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
-        vTaskDelete(NULL);
-        return;
-    }
-
-    int err = bind(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err < 0) {
-        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
-        close(sock);
-        vTaskDelete(NULL);
-        return;
-    }
-    ESP_LOGI(TAG, "Socket bound, listening on port %d", UDP_PORT);
-
-    while (1) {
-        struct sockaddr_in source_addr;
-        socklen_t socklen = sizeof(source_addr);
-        int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer) - 1, 0, (struct sockaddr *)&source_addr, &socklen);
-        
-        if (len < 0) {
-            ESP_LOGW(TAG, "recvfrom failed: errno %d", errno);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            continue;
-        }
-        
-        rx_buffer[len] = 0;
-        ESP_LOGI(TAG, "Received: %s", rx_buffer);
-        
-        if (strncmp(rx_buffer, "VALUE:", 6) == 0) {
-            int motor_id = 0, value = 0;
-            if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &value) == 2 || sscanf(&rx_buffer[6], "%d", &value) == 1) {
-                if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &value) != 2) {
-                    motor_id = 0;
-                }
-                if (value > 2000) value = 2000;
-                if (value < -2000) value = -2000;
-                int angle = value_to_angle(value);
-                ESP_LOGI(TAG, "Motor %d: Converted value %d fpm to angle %d degrees", motor_id, value, angle);
-                motor_move_to(angle, 0, 360);
-            } else {
-                ESP_LOGW(TAG, "Failed to parse value from: %s", &rx_buffer[6]);
-            }
-        } else if (strncmp(rx_buffer, "ANGLE:", 6) == 0) {
-            int motor_id = 0, angle = 0;
-            if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &angle) == 2 || sscanf(&rx_buffer[6], "%d", &angle) == 1) {
-                if (sscanf(&rx_buffer[6], "%d:%d", &motor_id, &angle) != 2) {
-                    motor_id = 0;
-                }
-                ESP_LOGI(TAG, "Motor %d: Parsed angle: %d degrees", motor_id, angle);
-                motor_move_to(angle, 0, 360);
-            } else {
-                ESP_LOGW(TAG, "Failed to parse angle from: %s", &rx_buffer[6]);
-            }
-        } else if (strncmp(rx_buffer, "MOVE:", 5) == 0) {
-            int motor_id = 0, angle = 0, min_angle = 0, max_angle = 360;
-            sscanf(&rx_buffer[5], "%d:%d:%d:%d", &motor_id, &angle, &min_angle, &max_angle);
-            ESP_LOGI(TAG, "Motor %d -> %d degrees (range: %d-%d)", motor_id, angle, min_angle, max_angle);
-            motor_move_to(angle, min_angle, max_angle);
-        } else if (strncmp(rx_buffer, "ZERO:", 5) == 0) {
-            current_position = 270;
-            total_steps_from_zero = (270 * 2048) / 360;
-            ESP_LOGI(TAG, "Motor zeroed to 270 degrees (0 fpm)");
-        }
-    }
-
-    close(sock);
-    vTaskDelete(NULL);
-}
+static const instrument_desc_t vertspeed_desc = {
+    .name = "VERT SPEED",
+    .motor_count = 1,
+    .motors = {
+        {
+            .pin_in1 = MOTOR_IN1,
+            .pin_in2 = MOTOR_IN2,
+            .pin_in3 = MOTOR_IN3,
+            .pin_in4 = MOTOR_IN4,
+            .calibration = calibration,
+            .calibration_count = 9,
+            .min_angle = 0,
+            .max_angle = 360,
+            .zero_angle = 270,       // 0 fpm
+            .path_mode = MOTOR_PATH_WRAP_AVOID,
+            .avoid_angle = 90,       // Center of the 82°-98° gap
+            // Light needle: cruise at the stall floor, half the period of
+            // the heavier dials
+            .ramp_start_period_us = 5000,
+            .ramp_min_period_us = 700,
+            .ramp_step_us = 100,
+        },
+    },
+};
 
 void app_main(void)
 {
-    ESP_LOGI(TAG, "Starting VSI UDP receiver on port %d", UDP_PORT);
-    
-    esp_task_wdt_config_t wdt_config = {
-        .timeout_ms = 60000,
-        .idle_core_mask = (1 << portNUM_PROCESSORS) - 1,
-        .trigger_panic = true,
-    };
-    esp_task_wdt_init(&wdt_config);
-    
-    motor_init();
-    wifi_init();
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
-    
-    xTaskCreate(wifi_logging_task, "wifi_log", 4096, NULL, 2, NULL);
-    vTaskDelay(500 / portTICK_PERIOD_MS);
-    esp_log_set_vprintf(wifi_log_vprintf);
-    
-    xTaskCreate(heartbeat_task, "heartbeat", 4096, NULL, 5, NULL);
-    xTaskCreate(udp_receiver_task, "udp_receiver", 8192, NULL, 3, NULL);
-    
-    // Don't move the needle on startup - just set internal position
-    current_position = 270;
-    total_steps_from_zero = (270 * 2048) / 360;
-    ESP_LOGI(TAG, "Initialization complete. Ready for commands.");
-    
+    instrument_core_start(&vertspeed_desc);
+
+    // Main task just sleeps, no need to monitor it
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(10000));
     }
@@ -3,7 +3,7 @@ import socket
 import time
 import struct
 import json
-from threading import Thread
+from threading import Thread, Lock
 
 HEARTBEAT_PORT = 49002
 COMMAND_PORT = 49003
@@ -11,6 +11,7 @@ XPLANE_PORT = 49001
 XPLANE_IP = '192.168.5.57'  # X-Plane host IP
 XPLANE_SEND_PORT = 49000  # Port for sending commands to X-Plane
 ENCODER_PORT = 49004  # New: Inputs ESP sends encoder events here
+STATS_PORT = 49005  # ESPs send periodic performance stats frames here
 TIMEOUT = 30  # Increased from 15 to 30 seconds
 DEVICES_FILE = 'esp_devices.json'
 CALIBRATION_FILE = 'calibration.json'
@@ -82,6 +83,43 @@ def heartbeat_listener():
         except Exception as e:
             print(f"[ERROR] Heartbeat listener: {e}")
 
+def stats_listener():
+    """Record per-ESP performance stats frames (panel_stats_frame_t)"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('', STATS_PORT))
+    print(f"Listening for stats on port {STATS_PORT}")
+
+    while True:
+        try:
+            data, addr = sock.recvfrom(1024)
+            if len(data) != struct.calcsize(STATS_FORMAT):
+                continue
+            (magic, version, _, esp_id_raw, uptime, rx_packets, rx_binary,
+             rx_text, rx_errors, motor_steps, isr_overruns, log_dropped,
+             free_heap, max_dispatch_us) = struct.unpack(STATS_FORMAT, data)
+            if magic != PANEL_STATS_MAGIC:
+                continue
+            esp_id = esp_id_raw.split(b'\x00')[0].decode('ascii', errors='replace')
+            stats = {
+                'uptime': uptime,
+                'rx_packets': rx_packets,
+                'rx_binary': rx_binary,
+                'rx_text': rx_text,
+                'rx_errors': rx_errors,
+                'motor_steps': motor_steps,
+                'isr_overruns': isr_overruns,
+                'log_dropped': log_dropped,
+                'free_heap': free_heap,
+                'max_dispatch_us': max_dispatch_us,
+            }
+            if esp_id in esp_devices:
+                esp_devices[esp_id]['stats'] = stats
+            print(f"[STATS] {esp_id}: rx={rx_packets} (bin={rx_binary} err={rx_errors}) "
+                  f"steps={motor_steps} overruns={isr_overruns} logdrop={log_dropped} "
+                  f"heap={free_heap} max_dispatch={max_dispatch_us}us")
+        except Exception as e:
+            print(f"[ERROR] Stats listener: {e}")
+
 def check_offline():
     while True:
         time.sleep(5)
@@ -96,6 +134,118 @@ def check_offline():
                 print(f"[OFFLINE] {esp_id}")
                 del esp_devices[esp_id]
 
+# Binary command protocol (see esp-panel/components/instrument_core/include/panel_proto.h)
+# Frame: magic, opcode, motor_id, flags, value, min_angle, max_angle, seq, reserved
+PANEL_MAGIC = 0xA5
+PANEL_OP_VALUE = 0x01
+PANEL_OP_VALUE2 = 0x05
+panel_seq = 0
+
+# Stats frame (panel_stats_frame_t): magic, version, reserved, esp_id,
+# then uptime, rx_packets, rx_binary, rx_text, rx_errors, motor_steps,
+# isr_overruns, log_dropped, free_heap, max_dispatch_us
+PANEL_STATS_MAGIC = 0xA6
+STATS_FORMAT = '<BBH24s10I'
+
+# Latest per-motor values for instruments that take combined frames
+attitude_latest = {}
+
+def send_value(esp_id, motor_id, value):
+    """Send a binary VALUE frame - avoids the sscanf parsing cost on the ESP"""
+    global panel_seq
+    if esp_id in esp_devices:
+        ip = esp_devices[esp_id]['ip']
+        panel_seq = (panel_seq + 1) & 0xFFFF
+        frame = struct.pack('<BBBBiiiHH', PANEL_MAGIC, PANEL_OP_VALUE, motor_id, 0,
+                            int(value), 0, 0, panel_seq, 0)
+        try:
+            sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            sock.sendto(frame, (ip, COMMAND_PORT))
+            print(f"→ {esp_id}: VALUE:{motor_id}:{value} (binary)")
+            sock.close()
+        except Exception as e:
+            print(f"Send error: {e}")
+    else:
+        print(f"✗ {esp_id} offline")
+
+def send_value2(esp_id, value0, value1):
+    """Send both motor targets in one VALUE2 frame (motor 0 in the value
+    field, motor 1 in the min_angle field) so paired axes update atomically"""
+    global panel_seq
+    if esp_id in esp_devices:
+        ip = esp_devices[esp_id]['ip']
+        panel_seq = (panel_seq + 1) & 0xFFFF
+        frame = struct.pack('<BBBBiiiHH', PANEL_MAGIC, PANEL_OP_VALUE2, 0, 0,
+                            int(value0), int(value1), 0, panel_seq, 0)
+        try:
+            sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            sock.sendto(frame, (ip, COMMAND_PORT))
+            print(f"→ {esp_id}: VALUE2:{value0}:{value1} (binary)")
+            sock.close()
+        except Exception as e:
+            print(f"Send error: {e}")
+    else:
+        print(f"✗ {esp_id} offline")
+
+# Multicast bundle mode: instead of a unicast datagram per instrument per
+# sim frame, pending values are packed into one bundle and multicast to the
+# whole panel, where each ESP filters by its own device ID. Every needle
+# then receives its data in the same airtime slot.
+MULTICAST_ENABLED = True
+MCAST_GROUP = '239.255.49.3'
+BUNDLE_FLUSH_INTERVAL = 0.02  # seconds; ~one bundle per sim frame at 30-50 Hz
+PANEL_BUNDLE_MAGIC = 0xA7
+
+pending_bundle = {}  # (esp_id, motor_id) -> value
+bundle_lock = Lock()
+
+def bundle_flusher():
+    global panel_seq
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+
+    while True:
+        time.sleep(BUNDLE_FLUSH_INTERVAL)
+        with bundle_lock:
+            if not pending_bundle:
+                continue
+            entries = list(pending_bundle.items())
+            pending_bundle.clear()
+
+        panel_seq = (panel_seq + 1) & 0xFFFF
+        packed_entries = []
+        for (esp_id, motor_id), value in entries:
+            encoded = esp_id.encode()
+            if len(encoded) > 24:
+                # struct.pack truncates silently and the ESP would never match
+                print(f"[WARN] esp_id '{esp_id}' exceeds 24 bytes, entry dropped")
+                continue
+            packed_entries.append(struct.pack('<24sBBHi', encoded, motor_id, 0, 0, int(value)))
+        if not packed_entries:
+            continue
+        frame = struct.pack('<BBH', PANEL_BUNDLE_MAGIC, len(packed_entries), panel_seq)
+        frame += b''.join(packed_entries)
+        try:
+            sock.sendto(frame, (MCAST_GROUP, COMMAND_PORT))
+        except Exception as e:
+            print(f"Bundle send error: {e}")
+
+def dispatch_value(esp_id, motor_id, value):
+    """Route a motor value to the ESP. In multicast mode values are batched
+    into one bundle per flush interval for the whole panel; otherwise the
+    attitude indicator gets pitch and roll combined into a single frame once
+    both have been seen, and everything else goes out as unicast VALUE."""
+    if MULTICAST_ENABLED:
+        with bundle_lock:
+            pending_bundle[(esp_id, motor_id)] = value
+        return
+    if esp_id == 'ESP_AttitudeIndicator':
+        attitude_latest[motor_id] = value
+        if 0 in attitude_latest and 1 in attitude_latest:
+            send_value2(esp_id, attitude_latest[0], attitude_latest[1])
+            return
+    send_value(esp_id, motor_id, value)
+
 def send_command(esp_id, message):
     if esp_id in esp_devices:
         ip = esp_devices[esp_id]['ip']
@@ -177,7 +327,7 @@ def xplane_listener():
                                     last_val = last_values.get(key, combined_value)
                                     if abs(combined_value - last_val) > 1:
                                         print(f"[X-Plane] {instrument_name}: {combined_value} {config.get('unit', '')} (Motor {motor_id}) [sum of {list(motor_accumulator[key]['drefs'].keys())}]")
-                                        send_command(esp_id, f"VALUE:{motor_id}:{combined_value}")
+                                        dispatch_value(esp_id, motor_id, combined_value)
                                         notify_webserver_xplane(field, combined_value, esp_id, motor_id)
                                         last_values[key] = combined_value
                             else:
@@ -196,101 +346,129 @@ def xplane_listener():
                                 if key not in last_values:
                                     # First time - always send
                                     print(f"[X-Plane] {instrument_name}: {final_value} {config.get('unit', '')} (Motor {motor_id})")
-                                    send_command(esp_id, f"VALUE:{motor_id}:{final_value}")
+                                    dispatch_value(esp_id, motor_id, final_value)
                                     notify_webserver_xplane(field, final_value, esp_id, motor_id)
                                     last_values[key] = final_value
                                 else:
                                     last_val = last_values[key]
                                     if abs(final_value - last_val) > 1:
                                         print(f"[X-Plane] {instrument_name}: {final_value} {config.get('unit', '')} (Motor {motor_id})")
-                                        send_command(esp_id, f"VALUE:{motor_id}:{final_value}")
+                                        dispatch_value(esp_id, motor_id, final_value)
                                         notify_webserver_xplane(field, final_value, esp_id, motor_id)
                                         last_values[key] = final_value
                             break
         except Exception as e:
             print(f"X-Plane error: {e}")
 
+def apply_encoder_delta(encoder_name, delta):
+    """Apply a signed detent delta to the encoder's DREF target"""
+    inputs_config = instrument_mapping.get('instruments', {}).get('ESP_Inputs', {})
+    encoders = inputs_config.get('encoders', {})
+    encoder_config = encoders.get(encoder_name)
+
+    if not encoder_config or delta == 0:
+        return
+
+    dref_path = encoder_config.get('dref')
+    encoder_type = encoder_config.get('type', 'relative')
+
+    if encoder_type != 'relative':
+        return
+
+    # Get current bug heading from X-Plane data
+    if encoder_name not in xplane_bug_heading:
+        xplane_bug_heading[encoder_name] = 0  # Default if not yet received
+
+    # Add delta to current heading
+    new_value = (xplane_bug_heading[encoder_name] + delta) % 360
+    if new_value < 0:
+        new_value += 360
+
+    xplane_bug_heading[encoder_name] = new_value
+    print(f"[{encoder_name}] Delta={delta}, New heading={new_value}°")
+
+    # Send to X-Plane via UDP
+    try:
+        xplane_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        import struct
+        # DREF format: "DREF\0" (5 bytes) + float (4 bytes) + dref_path (500 bytes, null-terminated then space-padded)
+        # Total: 509 bytes
+        dref_bytes = (dref_path.encode('utf-8') + b'\x00').ljust(500, b' ')
+        message = b"DREF\x00" + struct.pack('<f', float(new_value)) + dref_bytes
+        xplane_sock.sendto(message, (XPLANE_IP, XPLANE_SEND_PORT))
+        xplane_sock.close()
+        print(f"[X-PLANE] Sent {encoder_name}: {new_value}° to {dref_path}")
+    except Exception as e:
+        print(f"[ERROR] Failed to send to X-Plane: {e}")
+
+def notify_web_server(encoder_name, value, button):
+    """Notify web_server for UI updates"""
+    try:
+        import requests
+        payload = {'encoder': encoder_name, 'value': value, 'button': button}
+        response = requests.post('http://localhost:5000/api/encoder_event',
+                     json=payload,
+                     timeout=2)
+        print(f"[DEBUG] Web server response: {response.status_code}")  # Debug
+    except Exception as e:
+        print(f"[ERROR] Failed to notify web_server: {e}")
+
 def encoder_listener():
     """Listen for encoder events from Inputs ESP"""
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
     sock.bind(('', ENCODER_PORT))
     print(f"Listening for encoder events on port {ENCODER_PORT}")
-    
-    # Track last raw encoder positions
+
+    # Track last raw encoder positions (legacy ENCODER messages)
     encoder_last_raw = {}
-    
+    # Track last sequence numbers (batched ENCDELTA messages)
+    encoder_last_seq = {}
+
     while True:
         try:
             data, addr = sock.recvfrom(1024)
             msg = data.decode()
             print(f"[DEBUG] Received raw message: {msg}")  # Debug
-            
-            if msg.startswith("ENCODER:"):
+
+            if msg.startswith("ENCDELTA:"):
+                # Batched format: ENCDELTA:name:seq:delta:value:button
+                # One packet per batch window; delta is detents accumulated
+                # since the previous packet, value is the running total
+                parts = msg.split(":")
+                if len(parts) >= 6:
+                    encoder_name = parts[1]
+                    seq = int(parts[2])
+                    delta = int(parts[3])
+                    value = int(parts[4])
+                    button = parts[5]
+
+                    last_seq = encoder_last_seq.get(encoder_name)
+                    if last_seq is not None and (seq - last_seq) % 65536 != 1:
+                        print(f"[ENCODER] {encoder_name}: sequence gap {last_seq} -> {seq}, "
+                              f"movement may have been lost")
+                    encoder_last_seq[encoder_name] = seq
+
+                    print(f"[ENCODER] {encoder_name}: delta={delta}, value={value}, btn={button}")
+                    apply_encoder_delta(encoder_name, delta)
+                    notify_web_server(encoder_name, value, button)
+            elif msg.startswith("ENCODER:"):
                 parts = msg.split(":")
                 if len(parts) >= 4:
                     encoder_name = parts[1]
                     value = int(parts[2])
                     button = parts[3]
-                    
+
                     print(f"[ENCODER] {encoder_name}: value={value}, btn={button}")
-                    
-                    # Look up encoder configuration
-                    inputs_config = instrument_mapping.get('instruments', {}).get('ESP_Inputs', {})
-                    encoders = inputs_config.get('encoders', {})
-                    encoder_config = encoders.get(encoder_name)
-                    
-                    if encoder_config:
-                        dref_path = encoder_config.get('dref')
-                        encoder_type = encoder_config.get('type', 'relative')
-                        
-                        if encoder_type == 'relative':
-                            # Calculate delta from last raw value
-                            if encoder_name in encoder_last_raw:
-                                delta = value - encoder_last_raw[encoder_name]
-                            else:
-                                delta = 0  # First reading, no delta
-                            
-                            encoder_last_raw[encoder_name] = value
-                            
-                            if delta != 0:
-                                # Get current bug heading from X-Plane data
-                                if encoder_name not in xplane_bug_heading:
-                                    xplane_bug_heading[encoder_name] = 0  # Default if not yet received
-                                
-                                # Add delta to current heading
-                                new_value = (xplane_bug_heading[encoder_name] + delta) % 360
-                                if new_value < 0:
-                                    new_value += 360
-                                
-                                xplane_bug_heading[encoder_name] = new_value
-                                print(f"[{encoder_name}] Delta={delta}, New heading={new_value}°")
-                                
-                                # Send to X-Plane via UDP
-                                try:
-                                    xplane_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
-                                    import struct
-                                    # DREF format: "DREF\0" (5 bytes) + float (4 bytes) + dref_path (500 bytes, null-terminated then space-padded)
-                                    # Total: 509 bytes
-                                    dref_bytes = (dref_path.encode('utf-8') + b'\x00').ljust(500, b' ')
-                                    message = b"DREF\x00" + struct.pack('<f', float(new_value)) + dref_bytes
-                                    xplane_sock.sendto(message, (XPLANE_IP, XPLANE_SEND_PORT))
-                                    xplane_sock.close()
-                                    print(f"[X-PLANE] Sent {encoder_name}: {new_value}° to {dref_path}")
-                                except Exception as e:
-                                    print(f"[ERROR] Failed to send to X-Plane: {e}")
-                    
-                    # Notify web_server for UI updates
-                    try:
-                        import requests
-                        payload = {'encoder': encoder_name, 'value': value, 'button': button}
-                        print(f"[DEBUG] Sending to web_server: {payload}")  # Debug
-                        
-                        response = requests.post('http://localhost:5000/api/encoder_event',
-                                     json=payload,
-                                     timeout=2)
-                        print(f"[DEBUG] Web server response: {response.status_code}")  # Debug
-                    except Exception as e:
-                        print(f"[ERROR] Failed to notify web_server: {e}")
+
+                    # Calculate delta from last raw value
+                    if encoder_name in encoder_last_raw:
+                        delta = value - encoder_last_raw[encoder_name]
+                    else:
+                        delta = 0  # First reading, no delta
+                    encoder_last_raw[encoder_name] = value
+
+                    apply_encoder_delta(encoder_name, delta)
+                    notify_web_server(encoder_name, value, button)
             else:
                 print(f"[ERROR] Unknown encoder message format: {msg}")
         except Exception as e:
@@ -300,6 +478,9 @@ if __name__ == "__main__":
     print("=== RPi Hub ===")
     load_instrument_mapping()
     Thread(target=heartbeat_listener, daemon=True).start()
+    Thread(target=stats_listener, daemon=True).start()
+    if MULTICAST_ENABLED:
+        Thread(target=bundle_flusher, daemon=True).start()
     Thread(target=check_offline, daemon=True).start()
     Thread(target=xplane_listener, daemon=True).start()
     Thread(target=encoder_listener, daemon=True).start()  # New
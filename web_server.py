@@ -374,10 +374,15 @@ def calibration(esp_id):
         calibrations[esp_id]['min_angle'] = data.get('min_angle', 0)
         calibrations[esp_id]['max_angle'] = data.get('max_angle', 360)
         save_calibrations()
-        
-        cal_json = json.dumps(calibrations[esp_id])
-        send_command(esp_id, f"CAL:{cal_json}")
-        
+
+        # Push the table to the device: CAL:<motor>:<v1>,<a1>;<v2>,<a2>;...
+        # The firmware validates it, stores it in NVS and applies it live
+        motor_id = data.get('motor_id', 0)
+        points = sorted(calibrations[esp_id]['points'], key=lambda p: p['value'])
+        pairs = ';'.join(f"{int(p['value'])},{int(p['angle'])}" for p in points)
+        if pairs:
+            send_command(esp_id, f"CAL:{motor_id}:{pairs}")
+
         return jsonify({'status': 'ok'})
     
     cal = calibrations.get(esp_id, {})